@@ -23,6 +23,7 @@
 #pragma once
 
 #include <MTConfig.h>
+#include <MTTypes.h>
 
 #if MT_MSVC_COMPILER_FAMILY
 #include <crtdefs.h>
@@ -68,7 +69,7 @@ namespace MT
 			{
 			}
 
-			size_t GetStackSize()
+			size_t GetStackSize() const
 			{
 				return (char*)stackTop - (char*)stackBottom;
 			}
@@ -80,6 +81,18 @@ namespace MT
 
 		static StackDesc AllocStack(size_t size);
 		static void FreeStack(const StackDesc & desc);
+
+		// Returns physical pages of the stack below the top usedBytes to the OS. Content of the released pages is undefined.
+		static void ReleaseStackPages(const StackDesc & desc, size_t usedBytes);
+
+		// Page aligned memory [stackBottom, stackTop) backed by huge pages if possible: explicit huge pages first, then transparent huge pages.
+		// Falls back to regular pages. Guard page below stackBottom is present unless explicit huge pages are used.
+		static StackDesc AllocHugePages(size_t size);
+		static void FreeHugePages(const StackDesc & desc);
+
+		// Asks the OS to place pages of the page aligned range [p, p + size) to NUMA node, moves already touched pages.
+		// It is a hint, failures are ignored. Does nothing on platforms without NUMA memory policy support.
+		static void BindToNode(void* p, size_t size, uint32 nodeId);
 	};
 
 
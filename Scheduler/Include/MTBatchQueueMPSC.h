@@ -0,0 +1,311 @@
+// The MIT License (MIT)
+//
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+//
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+//
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#include <MTPlatform.h>
+#include <MTTools.h>
+#include <MTAppInterop.h>
+
+
+namespace MT
+{
+	/// \class BatchQueueMPSC
+	/// \brief Unbounded Lock-Free Multi-Producer Single-Consumer queue of item batches.
+	///
+	/// Producers never block and never fail. Items are stored in fixed size nodes, a batch is split into
+	/// as many nodes as it needs and the whole chain is linked with one atomic exchange.
+	/// Consumed nodes are recycled through a small free list, so memory is allocated only when the queue grows.
+	/// Consumer side is protected by try-lock, so any thread can pop items, but only one thread at a time.
+	/// Thread which failed to acquire the consumer lock just gets nothing.
+	///
+	/// based on Intrusive MPSC node-based queue by Dmitry Vyukov
+	/// http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+	///
+	template<typename T>
+	class BatchQueueMPSC
+	{
+		static const uint32 NODE_CAPACITY = 32;
+		static const uint32 MAX_FREE_NODES_COUNT = 64;
+
+		struct Node
+		{
+			AtomicPtr<Node> next;
+			uint32 count;
+			uint32 readIndex;
+		};
+
+		static const size_t ITEMS_OFFSET = (sizeof(Node) + __alignof(T) - 1) & ~(__alignof(T) - 1);
+		static const size_t NODE_SIZE = ITEMS_OFFSET + sizeof(T) * NODE_CAPACITY;
+
+		static T* GetItems(Node* node)
+		{
+			return (T*)((uint8*)node + ITEMS_OFFSET);
+		}
+
+		// Consumer side, modified only by thread which holds the consumer lock
+		Node* head;
+		Node* current;
+		Node stub;
+
+		// Prevent false sharing between threads
+		uint8 cacheline0[64];
+
+		// Producers side
+		AtomicPtr<Node> tail;
+
+		// Number of items in queue. Producers increment it before the items are linked,
+		// so queue is never reported empty while it has items, but can be reported not empty for a moment before they are visible.
+		Atomic32<int32> size;
+
+		// Prevent false sharing between threads
+		uint8 cacheline1[64];
+
+		Atomic32<uint32> consumerLock;
+
+		// Recycled nodes. Protected by try-lock: thread which failed to acquire it allocates or frees memory instead of waiting.
+		Atomic32<uint32> freeNodesLock;
+		Node* freeNodes;
+		uint32 freeNodesCount;
+
+		void PushChain(Node* first, Node* last)
+		{
+			last->next.StoreRelaxed(nullptr);
+			Node* prev = tail.Exchange(last);
+			prev->next.Store(first);
+		}
+
+		// Consumer only. Returns nullptr if queue is empty or producer is in the middle of push.
+		Node* PopNode()
+		{
+			Node* node = head;
+			Node* next = node->next.Load();
+			if (node == &stub)
+			{
+				if (next == nullptr)
+				{
+					return nullptr;
+				}
+
+				head = next;
+				node = next;
+				next = next->next.Load();
+			}
+
+			if (next != nullptr)
+			{
+				head = next;
+				return node;
+			}
+
+			if (node != tail.Load())
+			{
+				return nullptr;
+			}
+
+			PushChain(&stub, &stub);
+
+			next = node->next.Load();
+			if (next != nullptr)
+			{
+				head = next;
+				return node;
+			}
+
+			return nullptr;
+		}
+
+		Node* AllocNode()
+		{
+			if (freeNodesLock.CompareAndSwap(0, 1) == 0)
+			{
+				Node* node = freeNodes;
+				if (node != nullptr)
+				{
+					freeNodes = node->next.LoadRelaxed();
+					freeNodesCount--;
+				}
+				freeNodesLock.Store(0);
+
+				if (node != nullptr)
+				{
+					return node;
+				}
+			}
+
+			return (Node*)Memory::Alloc(NODE_SIZE);
+		}
+
+		void FreeNode(Node* node)
+		{
+			T* items = GetItems(node);
+			for (uint32 i = 0; i < node->count; i++)
+			{
+				items[i].~T();
+			}
+
+			if (freeNodesLock.CompareAndSwap(0, 1) == 0)
+			{
+				bool isRecycled = (freeNodesCount < MAX_FREE_NODES_COUNT);
+				if (isRecycled)
+				{
+					node->next.StoreRelaxed(freeNodes);
+					freeNodes = node;
+					freeNodesCount++;
+				}
+				freeNodesLock.Store(0);
+
+				if (isRecycled)
+				{
+					return;
+				}
+			}
+
+			Memory::Free(node);
+		}
+
+	public:
+
+		MT_NOCOPYABLE(BatchQueueMPSC);
+
+		BatchQueueMPSC()
+			: head(&stub)
+			, current(nullptr)
+			, freeNodes(nullptr)
+			, freeNodesCount(0)
+		{
+			stub.next.StoreRelaxed(nullptr);
+			stub.count = 0;
+			stub.readIndex = 0;
+
+			tail.StoreRelaxed(&stub);
+			size.StoreRelaxed(0);
+			consumerLock.StoreRelaxed(0);
+			freeNodesLock.StoreRelaxed(0);
+		}
+
+		~BatchQueueMPSC()
+		{
+			if (current != nullptr)
+			{
+				FreeNode(current);
+				current = nullptr;
+			}
+
+			while (Node* node = PopNode())
+			{
+				FreeNode(node);
+			}
+
+			while (freeNodes != nullptr)
+			{
+				Node* node = freeNodes;
+				freeNodes = node->next.LoadRelaxed();
+				Memory::Free(node);
+			}
+		}
+
+		// Any thread. Adds all items.
+		void Push(const T* itemArray, size_t count)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			Node* first = nullptr;
+			Node* last = nullptr;
+			for (size_t offset = 0; offset < count; offset += NODE_CAPACITY)
+			{
+				Node* node = AllocNode();
+				node->count = (uint32)Min(count - offset, (size_t)NODE_CAPACITY);
+				node->readIndex = 0;
+
+				T* items = GetItems(node);
+				for (uint32 i = 0; i < node->count; i++)
+				{
+					new(items + i) T(itemArray[offset + i]);
+				}
+
+				if (last == nullptr)
+				{
+					first = node;
+				} else
+				{
+					last->next.StoreRelaxed(node);
+				}
+				last = node;
+			}
+
+			// Publish size before items, consumer which sees an empty queue must not miss them
+			size.AddFetch((int32)count);
+			PushChain(first, last);
+		}
+
+		// Any thread. Returns the number of popped items, zero if queue is empty or other thread is popping now.
+		size_t TryPop(T* itemArray, size_t maxCount)
+		{
+			if (IsEmpty() || consumerLock.CompareAndSwap(0, 1) != 0)
+			{
+				return 0;
+			}
+
+			size_t count = 0;
+			while (count < maxCount)
+			{
+				if (current == nullptr)
+				{
+					current = PopNode();
+					if (current == nullptr)
+					{
+						break;
+					}
+				}
+
+				T* items = GetItems(current);
+				while (count < maxCount && current->readIndex < current->count)
+				{
+					itemArray[count] = items[current->readIndex];
+					current->readIndex++;
+					count++;
+				}
+
+				if (current->readIndex == current->count)
+				{
+					FreeNode(current);
+					current = nullptr;
+				}
+			}
+
+			size.AddFetch(-(int32)count);
+			consumerLock.Store(0);
+			return count;
+		}
+
+		// Any thread. Never true while queue has items, but can be false for a moment while producer is linking new items.
+		bool IsEmpty() const
+		{
+			return (size.Load() <= 0);
+		}
+
+	};
+}
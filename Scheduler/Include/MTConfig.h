@@ -158,8 +158,77 @@
 #endif
 
 
+//
+// mt_cacheline_aligned. Align type to cache line size, array elements of this type never share cache line
+//
+#if MT_MSVC_COMPILER_FAMILY
+#define mt_cacheline_aligned __declspec(align(64))
+#elif MT_GCC_COMPILER_FAMILY
+#define mt_cacheline_aligned __attribute__((aligned(64)))
+#else
+#error Can not define mt_cacheline_aligned. Unknown platform.
+#endif
+
+
 // Enable Windows XP support (disable conditional variables)
 //#if !MT_PTR64 && MT_PLATFORM_WINDOWS
 //#define MT_ENABLE_LEGACY_WINDOWSXP_SUPPORT (1)
 //#endif
 
+
+// Use futex based Event and adaptive spinning Mutex instead of pthread ones (Linux only)
+#ifndef MT_ENABLE_FUTEX_SYNC
+#if MT_PLATFORM_POSIX && defined(__linux__)
+#define MT_ENABLE_FUTEX_SYNC (1)
+#else
+#define MT_ENABLE_FUTEX_SYNC (0)
+#endif
+#endif
+
+
+// Use register only fiber context switch instead of ucontext (Linux x86-64 only)
+#ifndef MT_ENABLE_ASM_FIBER_SWITCH
+#if MT_PLATFORM_POSIX && defined(__linux__) && defined(__x86_64__)
+#define MT_ENABLE_ASM_FIBER_SWITCH (1)
+#else
+#define MT_ENABLE_ASM_FIBER_SWITCH (0)
+#endif
+#endif
+
+
+// Use mutex protected task queues instead of lock-free work stealing queues (useful for A/B benchmarking)
+//#define MT_ENABLE_LOCKING_TASK_QUEUE (1)
+
+
+// Maximum number of tasks moved from a victim queue by a single steal (thief takes up to half of the victim queue)
+#ifndef MT_TASK_STEAL_BATCH_MAX_COUNT
+#define MT_TASK_STEAL_BATCH_MAX_COUNT (32)
+#endif
+
+
+// Maximum number of queued tasks a finished fiber runs in a row before it returns to the scheduler fiber
+#ifndef MT_FIBER_REUSE_MAX_COUNT
+#define MT_FIBER_REUSE_MAX_COUNT (16)
+#endif
+
+
+// Fill fiber stacks with a pattern and measure peak stack usage per task type and per stack class.
+// Slow, commits whole fiber stacks. Requires fibers with own stack memory (not available for CreateFiber based Windows fibers).
+//#define MT_ENABLE_STACK_USAGE_TRACKING (1)
+
+
+// Maximum number of task types tracked by stack usage tracking
+#ifndef MT_STACK_USAGE_MAX_TASK_TYPES
+#define MT_STACK_USAGE_MAX_TASK_TYPES (256)
+#endif
+
+
+// Maximum number of NUMA nodes with own fiber pools. Workers on the other nodes share the pools of the first node.
+#ifndef MT_MAX_NUMA_NODES_COUNT
+#define MT_MAX_NUMA_NODES_COUNT (8)
+#endif
+
+
+// Distribute all tasks between worker queues using round robin
+// instead of adding tasks spawned by worker to its own queue and tasks from external threads to the global injection queue
+//#define MT_ENABLE_ROUND_ROBIN_SUBMISSION (1)
@@ -0,0 +1,92 @@
+// The MIT License (MIT)
+//
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+//
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+//
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#include <MTPlatform.h>
+
+#define MT_NUMA_NODE_ANY (0xffffffff)
+
+namespace MT
+{
+	namespace StealDistance
+	{
+		enum Type
+		{
+			// Hardware threads of the same physical core
+			SMT_SIBLING = 0,
+
+			// Different cores sharing the last level cache
+			SHARED_CACHE = 1,
+
+			// Same NUMA node, different last level cache
+			SAME_NODE = 2,
+
+			// Different NUMA node or unknown topology
+			REMOTE = 3,
+
+			COUNT
+		};
+	}
+
+
+	/// \class CpuTopology
+	/// \brief Logical processors topology: physical cores, last level caches and NUMA nodes.
+	///
+	/// Linux reads topology from /sys/devices/system/cpu, on other platforms Query returns false and all processors are treated as remote.
+	///
+	class CpuTopology
+	{
+		struct CpuInfo
+		{
+			uint32 coreId;
+			uint32 cacheId;
+			uint32 nodeId;
+			bool isValid;
+		};
+
+		CpuInfo* cpus;
+		uint32 cpusCount;
+
+		bool QueryPlatformTopology();
+
+	public:
+
+		MT_NOCOPYABLE(CpuTopology);
+
+		CpuTopology();
+		~CpuTopology();
+
+		/// \brief Reads processors topology.
+		/// \return false if topology is not available on this platform
+		bool Query();
+
+		uint32 GetCpuCount() const;
+
+		/// \brief Returns distance between two logical processors. Unknown processors are remote.
+		StealDistance::Type GetDistance(uint32 cpuA, uint32 cpuB) const;
+
+		/// \brief Returns NUMA node of logical processor or MT_NUMA_NODE_ANY if it is unknown.
+		uint32 GetNodeId(uint32 cpu) const;
+	};
+
+}
@@ -35,6 +35,12 @@ namespace MT
 {
 	class TaskHandle;
 
+	namespace internal
+	{
+		struct ThreadContext;
+		class FiberWaitList;
+	}
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Fiber task status
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +55,9 @@ namespace MT
 			FINISHED = 2,
 			YIELDED = 3,
 			AWAITING_CHILD = 4,
+			AWAITING_GROUP = 5,
+			AWAITING_COUNTER = 6,
+			AWAITING_SYNC = 7,
 		};
 	}
 
@@ -60,8 +69,13 @@ namespace MT
 	{
 	private:
 
+		friend class internal::FiberWaitList;
+
 		void RunSubtasksAndYieldImpl(ArrayView<internal::TaskBucket>& buckets);
 
+		// Switches to the scheduler fiber, status tells the scheduler when the fiber has to be resumed.
+		void SuspendAndYield(FiberTaskStatus::Type status);
+
 	public:
 
 		FiberContext();
@@ -70,15 +84,23 @@ namespace MT
 		void RunSubtasksAndYield(TaskGroup taskGroup, const TTask* taskArray, size_t taskCount);
 
 		template<class TTask>
-		void RunAsync(TaskGroup taskGroup, const TTask* taskArray, size_t taskCount);
+		void RunAsync(TaskGroup taskGroup, const TTask* taskArray, size_t taskCount, TaskCounter* counter = nullptr);
 
 		//
-		void RunAsync(TaskGroup taskGroup, const TaskHandle* taskHandleArray, uint32 taskHandleCount);
+		void RunAsync(TaskGroup taskGroup, const TaskHandle* taskHandleArray, uint32 taskHandleCount, TaskCounter* counter = nullptr);
 		void RunSubtasksAndYield(TaskGroup taskGroup, const TaskHandle* taskHandleArray, uint32 taskHandleCount);
 
 		//
 		void Yield();
 
+		/// \brief Suspends the task until all tasks of the group are finished. Worker thread runs other tasks meanwhile.
+		/// Fiber is resumed by the worker which finished the last task of the group. Task can't wait for its own group.
+		void WaitGroupAndYield(TaskGroup group);
+
+		/// \brief Suspends the task until the counter drops to the target value or below. Worker thread runs other tasks meanwhile.
+		/// Fiber is resumed by the worker which finished the task that reached the target.
+		void WaitCounterAndYield(TaskCounter& counter, int32 targetValue = 0);
+
 		void Reset();
 
 		void SetThreadContext(internal::ThreadContext * _threadContext);
@@ -103,6 +125,9 @@ namespace MT
 		// Active task group
 		TaskGroup currentGroup;
 
+		// Counter of the active task (null if task was submitted without counter)
+		TaskCounter* currentCounter;
+
 		// Requirements for stack
 		StackRequirements::Type stackRequirements;
 
@@ -112,12 +137,33 @@ namespace MT
 		// Parent fiber
 		FiberContext* parentFiber;
 
+		// Parent fiber which should be resumed by scheduler, set when the last subtask is finished
+		FiberContext* readyParentFiber;
+
+		// Next fiber waiting for the same task group, counter or synchronization primitive
+		FiberContext* nextWaitingFiber;
+
+		// Counter value the fiber is waiting for
+		int32 waitTargetValue;
+
 		// System fiber
 		Fiber fiber;
 
 		//Fiber index in pool
 		uint32 fiberIndex;
 
+		// Fiber stack was touched since its pages were released to the OS
+		bool hasResidentStack;
+
+		// Time when fiber was returned to the pool (microseconds), set only if idle stacks release is enabled
+		int64 idleStartTime;
+
+		// Stack position where the fiber is parked while it is in the pool
+		void* idleStackPointer;
+
+		// NUMA node (scheduler node index) where the fiber stack is placed, fiber is returned to the pool of this node
+		uint32 nodeIndex;
+
 		// Prevent false sharing between threads
 		uint8 cacheline[64];
 	};
@@ -26,8 +26,8 @@ namespace MT
 	template<class TTask>
 	void FiberContext::RunSubtasksAndYield(TaskGroup taskGroup, const TTask* taskArray, size_t taskCount)
 	{
-		MT_ASSERT(taskCount < (internal::TASK_BUFFER_CAPACITY - 1), "Too many tasks per one Run.");
 		MT_ASSERT(threadContext, "ThreadContext is nullptr");
+		MT_ASSERT(taskCount < (threadContext->taskScheduler->GetTaskQueueCapacity() - 1), "Too many tasks per one Run.");
 
 		TaskScheduler& scheduler = *(threadContext->taskScheduler);
 
@@ -41,11 +41,11 @@ namespace MT
 	}
 
 	template<class TTask>
-	void FiberContext::RunAsync(TaskGroup taskGroup, const TTask* taskArray, size_t taskCount)
+	void FiberContext::RunAsync(TaskGroup taskGroup, const TTask* taskArray, size_t taskCount, TaskCounter* counter)
 	{
-		MT_ASSERT(taskCount < (internal::TASK_BUFFER_CAPACITY - 1), "Too many tasks per one Run.");
-
 		MT_ASSERT(threadContext, "ThreadContext is nullptr");
+		MT_ASSERT(taskCount < (threadContext->taskScheduler->GetTaskQueueCapacity() - 1), "Too many tasks per one Run.");
+
 		MT_ASSERT(threadContext->taskScheduler->IsWorkerThread(), "Can't use RunAsync outside Task. Use TaskScheduler.RunAsync() instead.");
 
 		TaskScheduler& scheduler = *(threadContext->taskScheduler);
@@ -56,7 +56,7 @@ namespace MT
 		ArrayView<internal::TaskBucket>	buckets(MT_ALLOCATE_ON_STACK(sizeof(internal::TaskBucket) * bucketCount), bucketCount);
 
 		internal::DistibuteDescriptions(taskGroup, taskArray, buffer, buckets);
-		scheduler.RunTasksImpl(buckets, nullptr, false);
+		scheduler.RunTasksImpl(buckets, nullptr, false, threadContext, counter);
 	}
 
 
@@ -0,0 +1,195 @@
+// The MIT License (MIT)
+// 
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+// 
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+// 
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+
+#pragma once
+
+#include <MTPlatform.h>
+
+namespace MT
+{
+	class FiberContext;
+	class TaskScheduler;
+
+	namespace internal
+	{
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Spin lock which protects the state of fiber synchronization primitive. Held for a few instructions only.
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class FiberSyncSpinLock
+		{
+			Atomic32<int32> state;
+
+		public:
+
+			MT_NOCOPYABLE(FiberSyncSpinLock);
+
+			FiberSyncSpinLock()
+			{
+			}
+
+			void Lock()
+			{
+				SpinWait spinWait;
+				while (state.LoadRelaxed() != 0 || state.CompareAndSwap(0, 1) != 0)
+				{
+					spinWait.SpinOnce();
+				}
+			}
+
+			void Unlock()
+			{
+				state.Store(0);
+			}
+		};
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// FIFO list of fibers suspended by synchronization primitive, linked by FiberContext::nextWaitingFiber
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Push, Pop, PopAll and GetScheduler are called under the primitive spin lock. Suspend and Resume are called after the lock
+		// is released. Fiber holds a wait token from Push until it is suspended, so Resume can't run the fiber before it left the thread.
+		// Resumed fiber can destroy the primitive at once, so Resume is static and releasing code must not touch the primitive after it.
+		class FiberWaitList
+		{
+			FiberContext* head;
+			FiberContext* tail;
+
+			// Scheduler which resumes the fibers
+			TaskScheduler* scheduler;
+
+		public:
+
+			MT_NOCOPYABLE(FiberWaitList);
+
+			FiberWaitList();
+			~FiberWaitList();
+
+			bool IsEmpty() const
+			{
+				return (head == nullptr);
+			}
+
+			void Push(FiberContext& fiberContext);
+
+			FiberContext* Pop();
+
+			// Takes the whole list, fibers are linked by FiberContext::nextWaitingFiber
+			FiberContext* PopAll();
+
+			// Scheduler of the waiting fibers, null if nobody has waited yet
+			TaskScheduler* GetScheduler() const
+			{
+				return scheduler;
+			}
+
+			// Resumes popped fiber (or the whole list taken by PopAll)
+			static void Resume(TaskScheduler* scheduler, FiberContext* fiberContext);
+
+			// Suspends pushed fiber, worker thread runs other tasks until the fiber is resumed
+			static void Suspend(FiberContext& fiberContext);
+		};
+	}
+
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Fiber synchronization primitives
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Contended Lock / Acquire / Wait suspend the task instead of blocking the worker thread, worker runs other tasks meanwhile.
+	// Waiters are served in FIFO order and ownership is handed over to the resumed fiber directly.
+	// Blocking operations are available from tasks only (not from stackless ones), releasing operations can be called from any thread.
+
+	class FiberMutex
+	{
+		internal::FiberSyncSpinLock spinLock;
+		internal::FiberWaitList waiters;
+		bool isLocked;
+
+	public:
+
+		MT_NOCOPYABLE(FiberMutex);
+
+		FiberMutex();
+
+		void Lock(FiberContext& fiberContext);
+		bool TryLock();
+		void Unlock();
+	};
+
+
+	class FiberSemaphore
+	{
+		internal::FiberSyncSpinLock spinLock;
+		internal::FiberWaitList waiters;
+		int32 count;
+
+	public:
+
+		MT_NOCOPYABLE(FiberSemaphore);
+
+		explicit FiberSemaphore(int32 initialCount);
+
+		void Acquire(FiberContext& fiberContext);
+		bool TryAcquire();
+		void Release(int32 releaseCount = 1);
+	};
+
+
+	// Wait releases the mutex and suspends the task, mutex is locked again before Wait returns.
+	class FiberConditionVariable
+	{
+		internal::FiberSyncSpinLock spinLock;
+		internal::FiberWaitList waiters;
+
+	public:
+
+		MT_NOCOPYABLE(FiberConditionVariable);
+
+		FiberConditionVariable();
+
+		void Wait(FiberContext& fiberContext, FiberMutex& mutex);
+		void NotifyOne();
+		void NotifyAll();
+	};
+
+
+	// Readers and writers take turns: new readers wait while any writer is waiting, unlocking writer lets in all waiting readers.
+	class FiberRWLock
+	{
+		internal::FiberSyncSpinLock spinLock;
+		internal::FiberWaitList waitingReaders;
+		internal::FiberWaitList waitingWriters;
+		int32 readersCount;
+		bool isWriterActive;
+
+	public:
+
+		MT_NOCOPYABLE(FiberRWLock);
+
+		FiberRWLock();
+
+		void LockShared(FiberContext& fiberContext);
+		void UnlockShared();
+
+		void Lock(FiberContext& fiberContext);
+		void Unlock();
+	};
+}
@@ -25,6 +25,7 @@
 #include <MTTools.h>
 #include <MTPlatform.h>
 #include <MTTaskGroup.h>
+#include <MTTaskCounter.h>
 #include <MTTaskDesc.h>
 
 namespace MT
@@ -38,17 +39,20 @@ namespace MT
 		{
 			FiberContext* awaitingFiber;
 			FiberContext* parentFiber;
+			TaskCounter* counter;
 			TaskGroup group;
 			TaskDesc desc;
 
 			GroupedTask()
 				: awaitingFiber(nullptr)
 				, parentFiber(nullptr)
+				, counter(nullptr)
 			{}
 
 			GroupedTask(const TaskDesc& _desc, TaskGroup _group)
 				: awaitingFiber(nullptr)
 				, parentFiber(nullptr)
+				, counter(nullptr)
 				, group(_group)
 				, desc(_desc)
 			{}
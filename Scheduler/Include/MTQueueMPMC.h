@@ -23,6 +23,7 @@
 #pragma once
 
 #include <MTTools.h>
+#include <MTAppInterop.h>
 #include <utility>
 
 namespace MT
@@ -30,15 +31,15 @@ namespace MT
 	/// \class ConcurrentQueueLIFO
 	/// \brief Lock-Free Multi-Producer Multi-Consumer Queue with fixed capacity.
 	///
+	/// Capacity is set at run time, but can't be changed after the queue was created.
+	///
 	/// based on Bounded MPMC queue article by Dmitry Vyukov
 	/// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
 	///
-	template<typename T, uint32 CAPACITY>
+	template<typename T>
 	class LockFreeQueueMPMC
 	{
-		static const int32 ALIGNMENT = 16;
-		static const int32 ALIGNMENT_MASK = (ALIGNMENT-1);
-		static const uint32 MASK = (CAPACITY - 1);
+		static const int32 ALIGNMENT = 64;
 
 		struct Cell
 		{
@@ -46,13 +47,9 @@ namespace MT
 			T data;
 		};
 
-		// Raw memory buffer
-		byte rawMemory[ sizeof(Cell) * CAPACITY + ALIGNMENT ];
-
-		// Prevent false sharing between threads
-		uint8 cacheline0[64];
-
-		Cell* const buffer;
+		Cell* buffer;
+		uint32 mask;
+		bool isExternalBuffer;
 
 		// Prevent false sharing between threads
 		uint8 cacheline1[64];
@@ -75,27 +72,81 @@ namespace MT
 		MT_NOCOPYABLE(LockFreeQueueMPMC);
 
 		LockFreeQueueMPMC()
-			: buffer( (Cell*)( ( (uintptr_t)&rawMemory[0] + ALIGNMENT_MASK ) & ~(uintptr_t)ALIGNMENT_MASK ) )
+			: buffer(nullptr)
+			, mask(0)
+			, isExternalBuffer(false)
 		{
-			static_assert( MT::StaticIsPow2<CAPACITY>::result, "LockFreeQueueMPMC capacity must be power of 2");
+			enqueuePos.StoreRelaxed(0);
+			dequeuePos.StoreRelaxed(0);
+		}
 
-			for (uint32 i = 0; i < CAPACITY; i++)
+		explicit LockFreeQueueMPMC(uint32 capacity)
+			: buffer(nullptr)
+			, mask(0)
+			, isExternalBuffer(false)
+		{
+			enqueuePos.StoreRelaxed(0);
+			dequeuePos.StoreRelaxed(0);
+
+			Create(capacity);
+		}
+
+		~LockFreeQueueMPMC()
+		{
+			if (buffer != nullptr)
+			{
+				if (isExternalBuffer == false)
+				{
+					Memory::Free(buffer);
+				}
+				buffer = nullptr;
+			}
+		}
+
+		// Size of the storage for the queue of given capacity
+		static size_t GetMemoryRequrementInBytes(uint32 capacity)
+		{
+			return sizeof(Cell) * capacity;
+		}
+
+		// Queue is just dummy until you call the Create
+		// externalBuffer is optional storage of GetMemoryRequrementInBytes(capacity) bytes, queue does not own it
+		void Create(uint32 capacity, void* externalBuffer = nullptr)
+		{
+			MT_ASSERT(buffer == nullptr, "Queue already created");
+			MT_ASSERT(IsPow2(capacity), "LockFreeQueueMPMC capacity must be power of 2");
+			MT_ASSERT(externalBuffer == nullptr || IsPointerAligned(externalBuffer, ALIGNMENT), "External buffer is not aligned");
+
+			isExternalBuffer = (externalBuffer != nullptr);
+			buffer = isExternalBuffer ? (Cell*)externalBuffer : (Cell*)Memory::Alloc(GetMemoryRequrementInBytes(capacity), ALIGNMENT);
+			mask = capacity - 1;
+
+			for (uint32 i = 0; i < capacity; i++)
 			{
 				buffer[i].sequence.StoreRelaxed(i);
 			}
+		}
 
-			enqueuePos.StoreRelaxed(0);
-			dequeuePos.StoreRelaxed(0);
+		bool IsCreated() const
+		{
+			return (buffer != nullptr);
+		}
+
+		uint32 GetCapacity() const
+		{
+			return (buffer != nullptr) ? (mask + 1) : 0;
 		}
 
 		bool TryPush(T && data)
 		{
+			MT_VERIFY(buffer, "Can't add items to dummy queue", return false; );
+
 			Cell* cell = nullptr;
 
 			uint32 pos = enqueuePos.LoadRelaxed();
 			for(;;)
 			{
-				cell = &buffer[pos & MASK];
+				cell = &buffer[pos & mask];
 
 				uint32 seq = cell->sequence.Load();
 				int32 dif = (int32)seq - (int32)pos;
@@ -131,12 +182,17 @@ namespace MT
 
 		bool TryPop(T& data)
 		{
+			if (buffer == nullptr)
+			{
+				return false;
+			}
+
 			Cell* cell = nullptr;
 			uint32 pos = dequeuePos.LoadRelaxed();
 
 			for (;;)
 			{
-				cell = &buffer[pos & MASK];
+				cell = &buffer[pos & mask];
 
 				uint32 seq = cell->sequence.Load();
 				int32 dif = (int32)seq - (int32)(pos + 1);
@@ -165,7 +221,7 @@ namespace MT
 
 			// successfully found a cell
 			MoveCtor( &data, std::move(cell->data) );
-			cell->sequence.Store(pos + MASK + 1);
+			cell->sequence.Store(pos + mask + 1);
 			return true;
 		}
 
@@ -32,7 +32,10 @@
 #include <MTFiberContext.h>
 #include <MTAppInterop.h>
 #include <MTTaskPool.h>
+#include <MTTaskCounter.h>
+#include <MTFiberSync.h>
 #include <MTStackRequirements.h>
+#include <MTCpuTopology.h>
 #include <Scopes/MTScopes.h>
 
 /*
@@ -174,15 +177,30 @@ namespace MT
 
 namespace MT
 {
-	const uint32 MT_MAX_THREAD_COUNT = 64;
+	// Default values of SchedulerConfig
 	const uint32 MT_SCHEDULER_STACK_SIZE = 1048576; // 1Mb
 
+	const uint32 MT_MAX_SMALL_FIBERS_COUNT = 256;
+	const uint32 MT_INITIAL_SMALL_FIBERS_COUNT = 0;
+	const uint32 MT_SMALL_FIBER_STACK_SIZE = 16384; //16Kb
+
 	const uint32 MT_MAX_STANDART_FIBERS_COUNT = 256;
+	const uint32 MT_INITIAL_STANDART_FIBERS_COUNT = 16;
 	const uint32 MT_STANDART_FIBER_STACK_SIZE = 32768; //32Kb
 
+	const uint32 MT_MAX_LARGE_FIBERS_COUNT = 64;
+	const uint32 MT_INITIAL_LARGE_FIBERS_COUNT = 0;
+	const uint32 MT_LARGE_FIBER_STACK_SIZE = 131072; //128Kb
+
 	const uint32 MT_MAX_EXTENDED_FIBERS_COUNT = 8;
+	const uint32 MT_INITIAL_EXTENDED_FIBERS_COUNT = 0;
 	const uint32 MT_EXTENDED_FIBER_STACK_SIZE = 1048576; // 1Mb
 
+	const uint32 MT_TASK_QUEUE_CAPACITY = 4096;
+
+	// Idle fiber stacks are never returned to the OS
+	const uint32 MT_FIBER_STACK_RELEASE_DISABLED = 0xFFFFFFFF;
+
 	namespace internal
 	{
 		struct ThreadContext;
@@ -202,13 +220,120 @@ namespace MT
 		uint32 core;
 		ThreadPriority::Type priority;
 
+		// Work stealing victims (worker indices), nearest first. Steal order is built from CPU topology if victimOrder is null.
+		const uint32* victimOrder;
+		uint32 victimOrderCount;
+
+		// NUMA node of the worker. Worker queues and fibers created by the worker are placed to this node.
+		// Taken from CPU topology of the worker core if set to MT_NUMA_NODE_ANY.
+		uint32 numaNode;
+
 		WorkerThreadParams()
 			: core(MT_CPUCORE_ANY)
 			, priority(ThreadPriority::DEFAULT)
+			, victimOrder(nullptr)
+			, victimOrderCount(0)
+			, numaNode(MT_NUMA_NODE_ANY)
+		{
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Fibers pool configuration (one pool per stack class)
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	struct FiberPoolConfig
+	{
+		// Maximum number of fibers. Constructor creates initial count of fibers, the rest are created on demand.
+		uint32 maxCount;
+		uint32 initialCount;
+		uint32 stackSize;
+
+		FiberPoolConfig()
+			: maxCount(0)
+			, initialCount(0)
+			, stackSize(0)
+		{
+		}
+
+		FiberPoolConfig(uint32 _maxCount, uint32 _initialCount, uint32 _stackSize)
+			: maxCount(_maxCount)
+			, initialCount(_initialCount)
+			, stackSize(_stackSize)
+		{
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Task scheduler run time configuration
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	struct SchedulerConfig
+	{
+		// Worker threads count. Automatically determines the required number of threads if set to 0
+		uint32 workerThreadsCount;
+
+		// Optional per worker parameters, array of workerThreadsCount elements
+		WorkerThreadParams* workerParameters;
+
+		TaskStealingMode::Type stealMode;
+
+		// Fibers pools indexed by stack class (StackRequirements::SMALL ... StackRequirements::EXTENDED).
+		// Entries for INVALID and STACKLESS must stay empty.
+		FiberPoolConfig fiberPools[StackRequirements::COUNT];
+
+		// Worker thread stack size (scheduler fiber)
+		uint32 schedulerStackSize;
+
+		// Capacity of each worker task queue, also limits the number of tasks per one RunAsync call. Must be power of 2.
+		uint32 taskQueueCapacity;
+
+		// Fibers which stay in the pool longer than this time (milliseconds) return unused stack pages to the OS.
+		// Checked by idle worker threads. Disabled by default.
+		uint32 fiberStackReleaseDelay;
+
+		// Place fiber stacks and task queues to huge pages to reduce TLB misses.
+		// Stacks of one fibers pool share one memory block without guard pages between them, stack overflow is not detected.
+		bool useHugePages;
+
+#ifdef MT_INSTRUMENTED_BUILD
+		IProfilerEventListener* profilerEventListener;
+#endif
+
+		SchedulerConfig()
+			: workerThreadsCount(0)
+			, workerParameters(nullptr)
+			, stealMode(TaskStealingMode::ENABLED)
+			, schedulerStackSize(MT_SCHEDULER_STACK_SIZE)
+			, taskQueueCapacity(MT_TASK_QUEUE_CAPACITY)
+			, fiberStackReleaseDelay(MT_FIBER_STACK_RELEASE_DISABLED)
+			, useHugePages(false)
+#ifdef MT_INSTRUMENTED_BUILD
+			, profilerEventListener(nullptr)
+#endif
 		{
+			fiberPools[StackRequirements::SMALL] = FiberPoolConfig(MT_MAX_SMALL_FIBERS_COUNT, MT_INITIAL_SMALL_FIBERS_COUNT, MT_SMALL_FIBER_STACK_SIZE);
+			fiberPools[StackRequirements::STANDARD] = FiberPoolConfig(MT_MAX_STANDART_FIBERS_COUNT, MT_INITIAL_STANDART_FIBERS_COUNT, MT_STANDART_FIBER_STACK_SIZE);
+			fiberPools[StackRequirements::LARGE] = FiberPoolConfig(MT_MAX_LARGE_FIBERS_COUNT, MT_INITIAL_LARGE_FIBERS_COUNT, MT_LARGE_FIBER_STACK_SIZE);
+			fiberPools[StackRequirements::EXTENDED] = FiberPoolConfig(MT_MAX_EXTENDED_FIBERS_COUNT, MT_INITIAL_EXTENDED_FIBERS_COUNT, MT_EXTENDED_FIBER_STACK_SIZE);
 		}
 	};
 
+#if MT_ENABLE_STACK_USAGE_TRACKING
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Peak stack usage of task type
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	struct TaskStackUsage
+	{
+		// Task type is identified by task entry point, debug name is available in instrumented build only
+		TTaskEntryPoint taskFunc;
+		const mt_char* debugID;
+
+		StackRequirements::Type stackRequirements;
+
+		// Peak stack depth in bytes, including scheduler frames at the top of the fiber stack
+		uint32 peakBytes;
+	};
+#endif
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Task scheduler
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -216,6 +341,7 @@ namespace MT
 	{
 		friend class FiberContext;
 		friend struct internal::ThreadContext;
+		friend class internal::FiberWaitList;
 
 
 
@@ -227,6 +353,12 @@ namespace MT
 		{
 			Atomic32<int32> inProgressTaskCount;
 
+			// Fibers suspended by WaitGroupAndYield, linked by FiberContext::nextWaitingFiber
+			AtomicPtr<FiberContext> waitingFibers;
+
+			// Number of external threads blocked in WaitGroup / WaitAll for this group
+			Atomic32<int32> externalWaitersCount;
+
 #if MT_GROUP_DEBUG
 			bool debugIsFree;
 #endif
@@ -258,6 +390,11 @@ namespace MT
 				return inProgressTaskCount.IncFetch();
 			}
 
+			Atomic32<int32>& GetExternalWaitersCount()
+			{
+				return externalWaitersCount;
+			}
+
 			int32 Add(int sum)
 			{
 				return inProgressTaskCount.AddFetch(sum);
@@ -268,6 +405,29 @@ namespace MT
 				return &inProgressTaskCount;
 			}
 
+			void PushWaitingFiber(FiberContext* fiberContext)
+			{
+				for(;;)
+				{
+					FiberContext* head = waitingFibers.Load();
+					fiberContext->nextWaitingFiber = head;
+					if (waitingFibers.CompareAndSwap(head, fiberContext) == head)
+					{
+						return;
+					}
+				}
+			}
+
+			// Takes the whole list of waiting fibers
+			FiberContext* PopWaitingFibers()
+			{
+				if (waitingFibers.Load() == nullptr)
+				{
+					return nullptr;
+				}
+				return waitingFibers.Exchange(nullptr);
+			}
+
 #if MT_GROUP_DEBUG
 			void SetDebugIsFree(bool _debugIsFree)
 			{
@@ -282,10 +442,110 @@ namespace MT
 		};
 
 
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Fibers pool
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Fiber contexts are allocated for the maximum count, but fibers (and their stacks) are created on demand.
+		// Task which can't get free fiber creates one, idle workers grow the pool in batches after that.
+		// When all fibers are in use, new tasks wait in the deferred queue instead of failing.
+		// Free fibers are kept per NUMA node, worker takes fibers of its own node first.
+		class FiberPool
+		{
+			FiberContext* fiberContexts;
+			uint32 maxCount;
+			uint32 stackSize;
+			uint32 firstFiberIndex;
+
+			// NUMA nodes of the scheduler (node ids indexed by node index)
+			const uint32* nodeIds;
+			uint32 nodesCount;
+
+			// Stacks of all fibers placed back to back (huge pages mode only)
+			Memory::StackDesc stacksMemory;
+
+			// Number of claimed fiber contexts, contexts are claimed in order
+			Atomic32<uint32> createdCount;
+
+			// Pool was empty on the node, idle worker of the node should grow it
+			Atomic32<uint32> isGrowRequested[MT_MAX_NUMA_NODES_COUNT];
+
+			// Number of fibers taken from the pool and its maximum value
+			Atomic32<uint32> inUseCount;
+			Atomic32<uint32> peakInUseCount;
+
+			// Free fibers indexed by node index
+			LockFreeQueueMPMC<FiberContext*> available[MT_MAX_NUMA_NODES_COUNT];
+
+			uint32 CreateFibers(uint32 count, uint32 nodeIndex, FiberContext** firstCreated);
+
+		public:
+
+			// New tasks which could not get a fiber, they are started when one of the fibers is returned to the pool
+			BatchQueueMPSC<internal::GroupedTask> deferredTasks;
+
+			MT_NOCOPYABLE(FiberPool);
+
+			FiberPool();
+			~FiberPool();
+
+			void Create(uint32 maxFibersCount, uint32 initialFibersCount, uint32 fiberStackSize, uint32 firstIndex, bool useHugePages, const uint32* numaNodeIds, uint32 numaNodesCount);
+
+			// Takes free fiber of the node, or of other node if the node has none, and requests the node pool to grow.
+			// Creates a fiber only if none of the fibers is in use. Returns nullptr if caller should defer the task.
+			FiberContext* TryPop(uint32 nodeIndex);
+
+			// Returns fiber to the pool of its node
+			bool TryPush(FiberContext*&& fiberContext);
+
+			// Creates a batch of fibers on the node if pool of the node was empty since the last call. Returns the number of created fibers.
+			uint32 GrowIfRequested(uint32 nodeIndex);
+
+			// Returns unused stack pages of fibers which are idle since idleStartTimeLimit (microseconds) or earlier
+			void ReleaseIdleStacks(int64 idleStartTimeLimit);
+
+			uint32 GetMaxCount() const
+			{
+				return maxCount;
+			}
+
+			uint32 GetCreatedCount() const
+			{
+				return createdCount.Load();
+			}
+
+			uint32 GetPeakInUseCount() const
+			{
+				return peakInUseCount.Load();
+			}
+		};
+
+
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// External thread blocked in WaitGroup / WaitAll
+		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Thread which finishes the last task of the group signals the event, so waiter does not poll the counter while sleeping.
+		struct ExternalWaiter
+		{
+			Atomic32<int32>* waitCounter;
+			Event wakeUpEvent;
+
+			ExternalWaiter* prev;
+			ExternalWaiter* next;
+
+			ExternalWaiter(Atomic32<int32>* _waitCounter)
+				: waitCounter(_waitCounter)
+				, wakeUpEvent(EventReset::AUTOMATIC, false)
+				, prev(nullptr)
+				, next(nullptr)
+			{
+			}
+		};
+
 		struct WaitContext
 		{
 			Atomic32<int32>* waitCounter;
 			internal::ThreadContext* threadContext;
+			ExternalWaiter* externalWaiter;
 			uint32 waitTimeMs;
 			uint32 exitCode;
 		};
@@ -297,30 +557,80 @@ namespace MT
 		// Started threads count
 		Atomic32<int32> startedThreadsCount;
 
-		std::array<ThreadId, 4 > waitingThreads;
-		Atomic32<int32> nextWaitingThreadSlotIndex;
+		// Number of workers waiting for new tasks
+		Atomic32<int32> parkedThreadsCount;
+
+		// How many times task queue was full and tasks were added to the overflow queue
+		Atomic32<uint32> overflowCount;
+
+		// How many times new task was deferred because all fibers were in use
+		Atomic32<uint32> deferredTasksCount;
+
+		// External threads blocked in WaitGroup / WaitAll, list is changed and walked under the lock
+		Mutex externalWaitersLock;
+		ExternalWaiter* externalWaiters;
 
 		// Threads created by task manager
 		Atomic32<int32> threadsCount;
 
-		internal::ThreadContext threadContext[MT_MAX_THREAD_COUNT];
+		// Worker thread contexts, array of threadContextsCount cache line aligned elements
+		internal::ThreadContext* threadContext;
+		uint32 threadContextsCount;
+
+		// Task queues of all workers (huge pages mode or several NUMA nodes only)
+		Memory::StackDesc taskQueuesMemory;
+
+		// Fiber stacks and task queues are placed to huge pages
+		bool isHugePagesEnabled;
+
+		// NUMA nodes of worker threads, node index is an index in this array.
+		// Node id is MT_NUMA_NODE_ANY if workers placement is unknown.
+		uint32 numaNodeIds[MT_MAX_NUMA_NODES_COUNT];
+		uint32 numaNodesCount;
+
+		// One bit per worker, set while worker is parked. Lets submitters find parked workers without touching every thread context
+		Atomic32Base<uint32>* parkedWorkersMask;
+		uint32 parkedWorkersMaskSize;
+
+		// Tasks submitted by external (non-worker) threads, workers drain these queues in batches
+		BatchQueueMPSC<internal::GroupedTask> injectionQueues[TaskPriority::COUNT];
 
 		// All groups task statistic
 		TaskGroupDescription allGroups;
 
 		// Groups pool
-		LockFreeQueueMPMC<TaskGroup, TaskGroup::MT_MAX_GROUPS_COUNT * 2> availableGroups;
+		LockFreeQueueMPMC<TaskGroup> availableGroups;
 
 		//
 		TaskGroupDescription groupStats[TaskGroup::MT_MAX_GROUPS_COUNT];
 
-		// Fibers context
-		FiberContext standartFiberContexts[MT_MAX_STANDART_FIBERS_COUNT];
-		FiberContext extendedFiberContexts[MT_MAX_EXTENDED_FIBERS_COUNT];
+		// Fibers pools indexed by stack class
+		FiberPool fiberPools[StackRequirements::COUNT];
 
-		// Fibers pool
-		LockFreeQueueMPMC<FiberContext*, MT_MAX_STANDART_FIBERS_COUNT * 2> standartFibersAvailable;
-		LockFreeQueueMPMC<FiberContext*, MT_MAX_EXTENDED_FIBERS_COUNT * 2> extendedFibersAvailable;
+#if MT_ENABLE_STACK_USAGE_TRACKING
+		struct TaskStackUsageSlot
+		{
+			AtomicPtr<void> taskFunc;
+			const mt_char* debugID;
+			StackRequirements::Type stackRequirements;
+			Atomic32<uint32> peakBytes;
+		};
+
+		// Peak stack usage per stack class and per task type (open addressing hash table, keyed by task entry point)
+		Atomic32<uint32> peakStackUsage[StackRequirements::COUNT];
+		TaskStackUsageSlot taskStackUsage[MT_STACK_USAGE_MAX_TASK_TYPES];
+
+		void UpdateStackUsage(const internal::TaskDesc& task, uint32 usedBytes);
+		static void TrackStackUsage(FiberContext& fiberContext);
+#endif
+
+		// Worker task queue capacity
+		uint32 taskQueueCapacity;
+
+		// Idle time before fiber stack pages are released (microseconds), negative if disabled
+		int64 fiberStackReleaseDelay;
+
+		void ReleaseIdleFiberStacks(int64 idleStartTimeLimit);
 
 #ifdef MT_INSTRUMENTED_BUILD
 		IProfilerEventListener * profilerEventListener;
@@ -328,24 +638,59 @@ namespace MT
 
 		bool taskStealingDisabled;
 
-		FiberContext* RequestFiberContext(internal::GroupedTask& task);
+		FiberContext* RequestFiberContext(internal::GroupedTask& task, uint32 nodeIndex);
 		void ReleaseFiberContext(FiberContext*&& fiberExecutionContext);
-		void RunTasksImpl(ArrayView<internal::TaskBucket>& buckets, FiberContext * parentFiber, bool restoredFromAwaitState);
+		void ResumeAwaitingFiber(FiberContext* fiberContext);
+		void AddGroupWaiter(TaskGroup group, FiberContext* fiberContext);
+		FiberContext* WakeUpGroupWaiters(TaskGroupDescription& groupDesc, bool canResumeOnCallerThread);
+
+		bool WaitExternal(TaskGroupDescription& groupDesc, uint32 milliseconds);
+		void AddExternalWaiter(TaskGroupDescription& groupDesc, ExternalWaiter& waiter);
+		void RemoveExternalWaiter(TaskGroupDescription& groupDesc, ExternalWaiter& waiter);
+		void WakeUpExternalWaiters(TaskGroupDescription& groupDesc);
+		void AddCounterWaiter(TaskCounter& counter, FiberContext* fiberContext);
+		FiberContext* DecrementCounter(TaskCounter& counter, bool canResumeOnCallerThread);
+		FiberContext* WakeUpCounterWaiters(TaskCounter& counter, bool canResumeOnCallerThread);
+		void DeferTask(internal::GroupedTask& task);
+		void RunDeferredTasks(StackRequirements::Type stackRequirements);
+		void RunDeferredTasks();
+		void RunTasksImpl(ArrayView<internal::TaskBucket>& buckets, FiberContext * parentFiber, bool restoredFromAwaitState, internal::ThreadContext* spawnerContext, TaskCounter* counter);
 		TaskGroupDescription & GetGroupDesc(TaskGroup group);
+		void InitNumaNodes(const WorkerThreadParams* workerParameters, const CpuTopology* topology);
+		void InitVictimOrder(const WorkerThreadParams* workerParameters, const CpuTopology* topology);
+
+		// Distance from the thief to the victim, StealDistance::COUNT if the thief never steals from the victim
+		static uint32 GetStealDistance(const internal::ThreadContext& thiefContext, uint32 victimIndex);
+		uint32 GetCurrentNodeIndex() const;
+		FiberPool& GetFiberPool(StackRequirements::Type stackRequirements);
+		const FiberPool& GetFiberPool(StackRequirements::Type stackRequirements) const;
+		void GrowFiberPools(uint32 nodeIndex);
+		bool TryWakeUpParkedWorker(internal::ThreadContext& context);
+		bool IsParkedWorker(uint32 workerIndex) const;
+		void SetParkedWorkerBit(uint32 workerIndex, bool isParked);
+		void WakeUpParkedWorkers(uint32 count, internal::ThreadContext* preferredContext, internal::ThreadContext* nearestToContext);
 
 		static void WorkerThreadMain( void* userData );
 		static void SchedulerFiberMain( void* userData );
 		static void SchedulerFiberWait( void* userData );
 		static bool SchedulerFiberStep( internal::ThreadContext& context, bool disableTaskStealing);
+		static bool TryGetTask( internal::ThreadContext& context, bool disableTaskStealing, internal::GroupedTask& task);
 		static void SchedulerFiberProcessTask( internal::ThreadContext& context, internal::GroupedTask& task );
 		static void FiberMain( void* userData );
 		static bool TryStealTask(internal::ThreadContext& threadContext, internal::GroupedTask & task);
+		static bool TryPopInjectedTask(internal::ThreadContext& threadContext, internal::GroupedTask & task);
 
 		static FiberContext* ExecuteTask (internal::ThreadContext& threadContext, FiberContext* fiberContext);
+		static FiberContext* FinishTask (internal::ThreadContext& threadContext, FiberContext* fiberContext);
+		static bool TryPopTaskForFiber(internal::ThreadContext& threadContext, FiberContext& fiberContext);
 
 	public:
 
 		/// \brief Initializes a new instance of the TaskScheduler class.
+		/// \param config Worker threads, fiber pools and task queues configuration
+		explicit TaskScheduler(const SchedulerConfig& config);
+
+		/// \brief Initializes a new instance of the TaskScheduler class with default configuration.
 		/// \param workerThreadsCount Worker threads count. Automatically determines the required number of threads if workerThreadsCount set to 0
 #ifdef MT_INSTRUMENTED_BUILD
 		TaskScheduler(uint32 workerThreadsCount = 0, WorkerThreadParams* workerParameters = nullptr, IProfilerEventListener* listener = nullptr, TaskStealingMode::Type stealMode = TaskStealingMode::ENABLED);
@@ -359,9 +704,9 @@ namespace MT
 		void JoinWorkerThreads();
 
 		template<class TTask>
-		void RunAsync(TaskGroup group, const TTask* taskArray, uint32 taskCount);
+		void RunAsync(TaskGroup group, const TTask* taskArray, uint32 taskCount, TaskCounter* counter = nullptr);
 
-		void RunAsync(TaskGroup group, const TaskHandle* taskHandleArray, uint32 taskHandleCount);
+		void RunAsync(TaskGroup group, const TaskHandle* taskHandleArray, uint32 taskHandleCount, TaskCounter* counter = nullptr);
 
 		/// \brief Wait while no more tasks in specific group.
 		/// \return true - if no more tasks in specific group. false - if timeout in milliseconds has reached and group still has some tasks.
@@ -378,6 +723,42 @@ namespace MT
 
 		bool IsWorkerThread() const;
 
+		/// \brief Returns the number of successful steals for each steal distance (all worker threads).
+		void GetStealDistanceHistogram(uint32 histogram[StealDistance::COUNT]) const;
+
+		/// \brief Returns how many times worker's task queue was full and tasks were added to the overflow queue.
+		uint32 GetQueueOverflowCount() const;
+
+		/// \brief Returns the number of NUMA nodes with own fiber pools (1 if workers placement is unknown).
+		uint32 GetNumaNodesCount() const;
+
+		/// \brief Returns worker task queue capacity. Number of tasks per one RunAsync call must be less than this value.
+		uint32 GetTaskQueueCapacity() const;
+
+		/// \brief Returns the maximum number of fibers for tasks with specified stack requirements.
+		uint32 GetFibersCount(StackRequirements::Type stackRequirements) const;
+
+		/// \brief Returns the number of fibers created so far for tasks with specified stack requirements.
+		uint32 GetCreatedFibersCount(StackRequirements::Type stackRequirements) const;
+
+		/// \brief Returns the maximum number of fibers simultaneously used by tasks with specified stack requirements.
+		uint32 GetPeakFibersInUseCount(StackRequirements::Type stackRequirements) const;
+
+		/// \brief Returns how many times new task was deferred because all fibers with required stack size were in use.
+		uint32 GetDeferredTasksCount() const;
+
+		/// \brief Returns unused stack pages of all idle fibers to the OS right now (for example, after a load spike).
+		void ReleaseIdleFiberStacks();
+
+#if MT_ENABLE_STACK_USAGE_TRACKING
+		/// \brief Returns peak stack depth in bytes of all finished tasks with specified stack requirements.
+		uint32 GetPeakStackUsage(StackRequirements::Type stackRequirements) const;
+
+		/// \brief Fills array with peak stack usage of finished task types.
+		/// \return Number of written items.
+		uint32 GetTaskStackUsage(TaskStackUsage* items, uint32 maxCount) const;
+#endif
+
 #ifdef MT_INSTRUMENTED_BUILD
 
 		inline IProfilerEventListener* GetProfilerEventListener()
@@ -47,6 +47,7 @@ namespace MT
 			MT_ASSERT(fiberContext->currentTask.stackRequirements == fiberContext->stackRequirements, "Sanity check failed");
 			internal::GroupedTask groupedTask( fiberContext->currentTask, fiberContext->currentGroup );
 			groupedTask.awaitingFiber = fiberContext;
+			groupedTask.counter = fiberContext->currentCounter;
 			return groupedTask;
 		}
 
@@ -99,9 +100,9 @@ namespace MT
 
 
 	template<class TTask>
-	void TaskScheduler::RunAsync(TaskGroup group, const TTask* taskArray, uint32 taskCount)
+	void TaskScheduler::RunAsync(TaskGroup group, const TTask* taskArray, uint32 taskCount, TaskCounter* counter)
 	{
-		MT_ASSERT(taskCount < (internal::TASK_BUFFER_CAPACITY - 1), "Too many tasks per one Run.");
+		MT_ASSERT(taskCount < (GetTaskQueueCapacity() - 1), "Too many tasks per one Run.");
 		MT_ASSERT(!IsWorkerThread(), "Can't use RunAsync inside Task. Use FiberContext.RunAsync() instead.");
 
 		uint32 bytesCountForGroupedTasks = sizeof(internal::GroupedTask) * taskCount;
@@ -112,7 +113,7 @@ namespace MT
 		ArrayView<internal::TaskBucket> buckets( MT_ALLOCATE_ON_STACK( bytesCountForTaskBuckets ), bucketCount );
 
 		internal::DistibuteDescriptions(group, taskArray, buffer, buckets);
-		RunTasksImpl(buckets, nullptr, false);
+		RunTasksImpl(buckets, nullptr, false, nullptr, counter);
 	}
 
 }
@@ -31,8 +31,22 @@ namespace MT
 		{
 			INVALID,
 
+			// Stack classes. Each class has its own fibers pool, see SchedulerConfig::fiberPools for stack sizes
+			SMALL,
 			STANDARD,
-			EXTENDED
+			LARGE,
+			EXTENDED,
+
+			// Task never yields and never calls RunSubtasksAndYield. Runs directly on the scheduler fiber without own fiber and stack.
+			STACKLESS,
+
+			COUNT
 		};
+
+		// Task with these requirements is executed on a fiber from the pool
+		inline bool IsFiberStack(Type type)
+		{
+			return (type > INVALID && type < STACKLESS);
+		}
 	}
 }
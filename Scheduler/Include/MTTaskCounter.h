@@ -0,0 +1,89 @@
+// The MIT License (MIT)
+// 
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+// 
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+// 
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+
+#pragma once
+
+#include <MTPlatform.h>
+
+namespace MT
+{
+	class FiberContext;
+	class TaskScheduler;
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Task counter
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Number of unfinished tasks submitted with the counter. Lightweight alternative to task groups for fine-grained joins:
+	// any number of counters can exist, counter does not need to be created or released by the scheduler.
+	// RunAsync increments the counter, each finished task decrements it. FiberContext::WaitCounterAndYield suspends the task
+	// until the counter drops to the target value.
+	//
+	// Counter must outlive all tasks submitted with it.
+	class TaskCounter
+	{
+		friend class TaskScheduler;
+
+		Atomic32<int32> value;
+
+		// Number of threads which are decrementing the counter or waking up its waiters right now
+		Atomic32<int32> activeUpdatesCount;
+
+		// Fibers suspended by WaitCounterAndYield, linked by FiberContext::nextWaitingFiber
+		AtomicPtr<FiberContext> waitingFibers;
+
+		void PushWaitingFiber(FiberContext* fiberContext);
+
+		// Takes the whole list of waiting fibers
+		FiberContext* PopWaitingFibers();
+
+	public:
+
+		MT_NOCOPYABLE(TaskCounter);
+
+		TaskCounter()
+		{
+		}
+
+		explicit TaskCounter(int32 initialValue)
+			: value(initialValue)
+		{
+		}
+
+		~TaskCounter()
+		{
+			MT_ASSERT(waitingFibers.Load() == nullptr, "Task counter is destroyed while fibers are waiting for it");
+
+			// Thread which finished the last task can be still waking up the waiters
+			SpinWait spinWait;
+			while (activeUpdatesCount.Load() != 0)
+			{
+				spinWait.SpinOnce();
+			}
+		}
+
+		int32 GetValue() const
+		{
+			return value.Load();
+		}
+	};
+}
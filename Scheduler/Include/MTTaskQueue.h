@@ -27,6 +27,8 @@
 #include <MTPlatform.h>
 #include <MTTools.h>
 #include <MTAppInterop.h>
+#include <MTQueueMPMC.h>
+#include <MTWorkStealingQueue.h>
 
 
 namespace MT
@@ -45,30 +47,24 @@ namespace MT
 		};
 	}
 
-	namespace DummyQueueFlag
-	{
-		enum Type
-		{
-			IS_DUMMY_QUEUE = 1
-		};
-	}
-
-
-	/// \class TaskQueue
-	/// \brief thread safe task queue
+	/// \class LockingTaskQueue
+	/// \brief thread safe task queue (mutex based)
+	///
+	/// Legacy implementation. Enabled by MT_ENABLE_LOCKING_TASK_QUEUE, useful for A/B benchmarking.
 	///
-	template<typename T, uint32 CAPACITY>
-	class TaskQueue
+	template<typename T>
+	class LockingTaskQueue
 	{
 		//////////////////////////////////////////////////////////////////////////
 		class Queue
 		{
 			static const int32 ALIGNMENT = 16;
-			static const unsigned int MASK = CAPACITY - 1u;
 
 			void* data;
+			size_t capacity;
 			size_t begin;
 			size_t end;
+			bool isExternalBuffer;
 
 			inline T* Buffer()
 			{
@@ -91,23 +87,12 @@ namespace MT
 				element->~T();
 			}
 
-			inline size_t Size() const
-			{
-				if (IsEmpty())
-				{
-					return 0;
-				}
-
-				size_t count = ((end & MASK) - (begin & MASK)) & MASK;
-				return count;
-			}
-
 			inline void Clear()
 			{
 				size_t queueSize = Size();
 				for (size_t i = 0; i < queueSize; i++)
 				{
-					T* pElement = Buffer() + ((begin + i) & MASK);
+					T* pElement = Buffer() + ((begin + i) & (capacity - 1));
 					Dtor(pElement);
 				}
 
@@ -119,16 +104,34 @@ namespace MT
 
 			Queue()
 				: data(nullptr)
+				, capacity(0)
 				, begin(0)
 				, end(0)
+				, isExternalBuffer(false)
 			{
 			}
 
+			// Size of the storage for the queue of given capacity
+			static size_t GetMemoryRequrementInBytes(uint32 _capacity)
+			{
+				return sizeof(T) * _capacity;
+			}
+
 			// Queue is just dummy until you call the Create
-			void Create()
+			// externalBuffer is optional storage of GetMemoryRequrementInBytes(capacity) bytes, queue does not own it
+			void Create(uint32 _capacity, void* externalBuffer = nullptr)
+			{
+				MT_ASSERT(IsPow2(_capacity), "Queue capacity must be power of 2");
+				MT_ASSERT(externalBuffer == nullptr || IsPointerAligned(externalBuffer, ALIGNMENT), "External buffer is not aligned");
+
+				capacity = _capacity;
+				isExternalBuffer = (externalBuffer != nullptr);
+				data = isExternalBuffer ? externalBuffer : Memory::Alloc(GetMemoryRequrementInBytes(_capacity), ALIGNMENT);
+			}
+
+			bool IsCreated() const
 			{
-				size_t bytesCount = sizeof(T) * CAPACITY;
-				data = Memory::Alloc(bytesCount, ALIGNMENT);
+				return (data != nullptr);
 			}
 
 
@@ -136,14 +139,17 @@ namespace MT
 			{
 				if (data != nullptr)
 				{
-					Memory::Free(data);
+					if (isExternalBuffer == false)
+					{
+						Memory::Free(data);
+					}
 					data = nullptr;
 				}
 			}
 
 			inline bool HasSpace(size_t itemCount)
 			{
-				if ((Size() + itemCount) >= CAPACITY)
+				if ((Size() + itemCount) >= capacity)
 				{
 					return false;
 				}
@@ -155,12 +161,12 @@ namespace MT
 			{
 				MT_VERIFY(data, "Can't add items to dummy queue", return false; );
 
-				if ((Size() + 1) >= CAPACITY)
+				if ((Size() + 1) >= capacity)
 				{
 					return false;
 				}
 
-				size_t index = (end & MASK);
+				size_t index = (end & (capacity - 1));
 				T* pElement = Buffer() + index;
 				CopyCtor( pElement, item );
 				end++;
@@ -178,7 +184,7 @@ namespace MT
 
 				MT_VERIFY(data, "Can't pop items from dummy queue", return false; );
 
-				size_t index = (begin & MASK);
+				size_t index = (begin & (capacity - 1));
 				T* pElement = Buffer() + index;
 				begin++;
 				item = *pElement;
@@ -196,7 +202,7 @@ namespace MT
 				MT_VERIFY(data, "Can't pop items from dummy queue", return false; );
 
 				end--;
-				size_t index = (end & MASK);
+				size_t index = (end & (capacity - 1));
 				T* pElement = Buffer() + index;
 				item = *pElement;
 				Dtor(pElement);
@@ -207,6 +213,17 @@ namespace MT
 			{
 				return (begin == end);
 			}
+
+			inline size_t Size() const
+			{
+				if (IsEmpty())
+				{
+					return 0;
+				}
+
+				size_t count = ((end & (capacity - 1)) - (begin & (capacity - 1))) & (capacity - 1);
+				return count;
+			}
 		};
 		//////////////////////////////////////////////////////////////////////////
 
@@ -215,26 +232,41 @@ namespace MT
 
 	public:
 
-		MT_NOCOPYABLE(TaskQueue);
+		MT_NOCOPYABLE(LockingTaskQueue);
 
-		TaskQueue()
+		LockingTaskQueue()
 		{
-			for(uint32 i = 0; i < MT_ARRAY_SIZE(queues); i++)
-			{
-				queues[i].Create();
-			}
 		}
 
-		TaskQueue(DummyQueueFlag::Type)
+		~LockingTaskQueue()
+		{
+		}
+
+		// Size of the storage for the queue of given capacity
+		static size_t GetMemoryRequrementInBytes(uint32 capacity)
+		{
+			return AlignUp(Queue::GetMemoryRequrementInBytes(capacity), 64) * MT_ARRAY_SIZE(queues);
+		}
+
+		// Queue is just dummy until you call the Create
+		// externalBuffer is optional storage of GetMemoryRequrementInBytes(capacity) bytes, queue does not own it
+		void Create(uint32 capacity, void* externalBuffer = nullptr)
 		{
-			// Create dummy queue.
+			size_t queueBytesCount = AlignUp(Queue::GetMemoryRequrementInBytes(capacity), 64);
+			for(uint32 i = 0; i < MT_ARRAY_SIZE(queues); i++)
+			{
+				queues[i].Create(capacity, externalBuffer ? (char*)externalBuffer + queueBytesCount * i : nullptr);
+			}
 		}
 
-		~TaskQueue()
+		// Dummy queue can't store items
+		bool IsCreated() const
 		{
+			return queues[0].IsCreated();
 		}
 
-		bool Add(const T* itemArray, size_t count)
+		// Returns the number of added items (all or nothing)
+		size_t Add(const T* itemArray, size_t count)
 		{
 			MT::ScopedGuard guard(mutex);
 
@@ -245,7 +277,7 @@ namespace MT
 				Queue& queue = queues[i];
 				if (!queue.HasSpace(count))
 				{
-					return false;
+					return 0;
 				}
 			}
 
@@ -263,10 +295,51 @@ namespace MT
 				MT_ASSERT(res == true, "Sanity check failed");
 			}
 
-			return true;
+			return count;
+		}
+
+		// Owner thread has no special path in locking queue
+		size_t AddLocal(const T* itemArray, size_t count)
+		{
+			return Add(itemArray, count);
+		}
+
+		// Owner thread pops oldest item
+		bool TryPopLocal(T & item)
+		{
+			return TryPopOldest(item);
+		}
+
+		// Other threads pop newest item
+		bool TrySteal(T & item)
+		{
+			return TryPopNewest(item);
 		}
 
 
+		// Other threads pop up to half of the newest items with the highest priority
+		size_t TryStealBatch(T* itemArray, size_t maxCount)
+		{
+			MT::ScopedGuard guard(mutex);
+			for(uint32 queueIndex = 0; queueIndex < TaskPriority::COUNT; queueIndex++)
+			{
+				Queue& queue = queues[queueIndex];
+				size_t count = MT::Min((queue.Size() + 1) / 2, maxCount);
+
+				size_t stolenCount = 0;
+				while (stolenCount < count && queue.TryPopNewest(itemArray[stolenCount]))
+				{
+					stolenCount++;
+				}
+
+				if (stolenCount > 0)
+				{
+					return stolenCount;
+				}
+			}
+			return 0;
+		}
+
 		bool TryPopOldest(T & item)
 		{
 			MT::ScopedGuard guard(mutex);
@@ -297,4 +370,175 @@ namespace MT
 
 
 	};
+
+
+
+	/// \class WorkStealingTaskQueue
+	/// \brief lock-free task queue
+	///
+	/// Each priority has a work stealing deque and an inbox.
+	/// Owner thread adds and pops tasks from the deque without locks, other workers steal from the opposite end of the deque.
+	/// Tasks added by other threads go to the lock-free multi-producer multi-consumer inbox.
+	///
+	template<typename T>
+	class WorkStealingTaskQueue
+	{
+		typedef LockFreeQueueMPMC<T> Inbox;
+
+		WorkStealingQueue<T> deques[TaskPriority::COUNT];
+		Inbox inboxes[TaskPriority::COUNT];
+
+		static uint32 GetQueueIndex(const T& item)
+		{
+			uint32 queueIndex = (uint32)item.desc.priority;
+			MT_ASSERT(queueIndex < TaskPriority::COUNT, "Invalid task priority");
+			return queueIndex;
+		}
+
+	public:
+
+		MT_NOCOPYABLE(WorkStealingTaskQueue);
+
+		WorkStealingTaskQueue()
+		{
+		}
+
+		~WorkStealingTaskQueue()
+		{
+		}
+
+		// Size of the storage for the queue of given capacity
+		static size_t GetMemoryRequrementInBytes(uint32 capacity)
+		{
+			size_t dequeBytesCount = AlignUp(WorkStealingQueue<T>::GetMemoryRequrementInBytes(capacity), 64);
+			size_t inboxBytesCount = AlignUp(Inbox::GetMemoryRequrementInBytes(capacity), 64);
+			return (dequeBytesCount + inboxBytesCount) * TaskPriority::COUNT;
+		}
+
+		// Queue is just dummy until you call the Create
+		// externalBuffer is optional storage of GetMemoryRequrementInBytes(capacity) bytes, queue does not own it
+		void Create(uint32 capacity, void* externalBuffer = nullptr)
+		{
+			size_t dequeBytesCount = AlignUp(WorkStealingQueue<T>::GetMemoryRequrementInBytes(capacity), 64);
+			size_t inboxBytesCount = AlignUp(Inbox::GetMemoryRequrementInBytes(capacity), 64);
+
+			char* buffer = (char*)externalBuffer;
+			for(uint32 i = 0; i < TaskPriority::COUNT; i++)
+			{
+				deques[i].Create(capacity, buffer);
+				inboxes[i].Create(capacity, buffer ? buffer + dequeBytesCount : nullptr);
+
+				if (buffer)
+				{
+					buffer += dequeBytesCount + inboxBytesCount;
+				}
+			}
+		}
+
+		// Dummy queue can't store items
+		bool IsCreated() const
+		{
+			return inboxes[0].IsCreated();
+		}
+
+		// Any thread. Returns the number of added items, items are added in order until the first failure.
+		size_t Add(const T* itemArray, size_t count)
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				Inbox& inbox = inboxes[GetQueueIndex(itemArray[i])];
+				MT_VERIFY(inbox.IsCreated(), "Can't add items to dummy queue", return i; );
+
+				T item(itemArray[i]);
+				if (!inbox.TryPush(std::move(item)))
+				{
+					return i;
+				}
+			}
+			return count;
+		}
+
+		// Owner thread only. Returns the number of added items (all or nothing)
+		size_t AddLocal(const T* itemArray, size_t count)
+		{
+			uint32 countPerQueue[TaskPriority::COUNT] = { 0 };
+			for(size_t i = 0; i < count; i++)
+			{
+				countPerQueue[GetQueueIndex(itemArray[i])]++;
+			}
+
+			for(uint32 queueIndex = 0; queueIndex < TaskPriority::COUNT; queueIndex++)
+			{
+				if (countPerQueue[queueIndex] > deques[queueIndex].GetFreeSpace())
+				{
+					return 0;
+				}
+			}
+
+			for(size_t i = 0; i < count; i++)
+			{
+				bool res = deques[GetQueueIndex(itemArray[i])].Push(&itemArray[i], 1);
+				MT_USED_IN_ASSERT(res);
+				MT_ASSERT(res == true, "Sanity check failed");
+			}
+
+			return count;
+		}
+
+		// Owner thread only. Pops newest local task or oldest task from inbox.
+		bool TryPopLocal(T & item)
+		{
+			for(uint32 queueIndex = 0; queueIndex < TaskPriority::COUNT; queueIndex++)
+			{
+				if (deques[queueIndex].TryPop(item))
+				{
+					return true;
+				}
+
+				if (inboxes[queueIndex].TryPop(item))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Any thread. Steals oldest task.
+		bool TrySteal(T & item)
+		{
+			for(uint32 queueIndex = 0; queueIndex < TaskPriority::COUNT; queueIndex++)
+			{
+				if (deques[queueIndex].TrySteal(item))
+				{
+					return true;
+				}
+
+				if (inboxes[queueIndex].TryPop(item))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Any thread. Steals up to half of the oldest tasks with the highest priority. Returns the number of stolen items.
+		size_t TryStealBatch(T* itemArray, size_t maxCount)
+		{
+			for(uint32 queueIndex = 0; queueIndex < TaskPriority::COUNT; queueIndex++)
+			{
+				uint32 stolenCount = deques[queueIndex].TryStealHalf(itemArray, (uint32)maxCount);
+				if (stolenCount > 0)
+				{
+					return stolenCount;
+				}
+
+				if (maxCount > 0 && inboxes[queueIndex].TryPop(itemArray[0]))
+				{
+					return 1;
+				}
+			}
+			return 0;
+		}
+
+	};
 }
@@ -25,8 +25,11 @@
 #include <MTTools.h>
 #include <MTPlatform.h>
 #include <MTTaskQueue.h>
+#include <MTBatchQueueMPSC.h>
 #include <MTConcurrentRingBuffer.h>
 #include <MTGroupedTask.h>
+#include <MTFiberContext.h>
+#include <MTCpuTopology.h>
 
 
 #ifdef MT_INSTRUMENTED_BUILD
@@ -61,9 +64,6 @@ namespace MT
 
 	namespace internal
 	{
-		static const size_t TASK_BUFFER_CAPACITY = 4096;
-
-
 		namespace ThreadState
 		{
 			const uint32 ALIVE = 0;
@@ -72,8 +72,9 @@ namespace MT
 
 		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		// Thread (Scheduler fiber) context
+		// Aligned to cache line to prevent false cache sharing between threads
 		////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-		struct ThreadContext
+		struct mt_cacheline_aligned ThreadContext
 		{
 			FiberContext* lastActiveFiberContext;
 
@@ -89,16 +90,30 @@ namespace MT
 			// scheduler fiber
 			Fiber schedulerFiber;
 
+			// Context for tasks with StackRequirements::STACKLESS, such tasks are executed on the scheduler fiber
+			FiberContext stacklessFiberContext;
+
 			// task queue awaiting execution
-			TaskQueue<internal::GroupedTask, TASK_BUFFER_CAPACITY> queue;
+#if MT_ENABLE_LOCKING_TASK_QUEUE
+			typedef LockingTaskQueue<internal::GroupedTask> TaskQueue;
+#else
+			typedef WorkStealingTaskQueue<internal::GroupedTask> TaskQueue;
+#endif
+			TaskQueue queue;
+
+			// tasks which did not fit into the task queue
+			BatchQueueMPSC<internal::GroupedTask> overflowQueue;
 
 			// new task has arrived to queue event
 			Event hasNewTasksEvent;
 
+			// worker is waiting for hasNewTasksEvent, submitters signal only parked workers
+			Atomic32<uint32> isParked;
+
 			// thread is alive or not
 			Atomic32<int32> state;
 
-			// Temporary buffer, fixed size = TASK_BUFFER_CAPACITY
+			// Temporary buffer, size = task queue capacity
 			void* descBuffer;
 
 			// Thread index
@@ -107,16 +122,38 @@ namespace MT
 			// Thread random number generator
 			LcgRandom random;
 
+			// Work stealing victims (worker indices) and distances to them, nearest first
+			uint32* victims;
+			uint8* victimDistances;
+			uint32 victimsCount;
+
+			// Victims with equal distance are visited from random position
+			bool isVictimOrderRandomized;
+
+			// Workers which have this worker in their victim order (worker indices), nearest first.
+			// They are woken up when the worker spawns more tasks than it can run itself.
+			uint32* thieves;
+			uint32 thievesCount;
+
+			// Number of successful steals per steal distance
+			Atomic32<uint32> stealDistanceHistogram[StealDistance::COUNT];
+
 			bool isExternalDescBuffer;
 
-			// prevent false cache sharing between threads
-			uint8 cacheline[64];
+			// NUMA node of the worker (scheduler node index)
+			uint32 nodeIndex;
 
 			ThreadContext();
 			ThreadContext(void* externalDescBuffer);
 			~ThreadContext();
 
+			// Allocates task queue and temporary buffer, worker thread contexts only
+			// externalMemory is optional storage of GetMemoryRequrementInBytesForTaskQueue() bytes, owned by the caller
+			void CreateTaskQueue(uint32 taskQueueCapacity, void* externalMemory = nullptr);
+
 			void SetThreadIndex(uint32 threadIndex);
+			void SetVictimsCount(uint32 count);
+			void SetThievesCount(uint32 count);
 
 #ifdef MT_INSTRUMENTED_BUILD
 			
@@ -137,7 +174,8 @@ namespace MT
 
 #endif
 
-			static size_t GetMemoryRequrementInBytesForDescBuffer();
+			static size_t GetMemoryRequrementInBytesForDescBuffer(uint32 taskQueueCapacity);
+			static size_t GetMemoryRequrementInBytesForTaskQueue(uint32 taskQueueCapacity);
 		};
 
 	}
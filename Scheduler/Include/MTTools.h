@@ -96,7 +96,32 @@ namespace MT
 			result = IsPow2Recurse< N - 1 >::result == N ? 1 : 0
 		};
 	};
-	
+
+
+	//Run time pow2 check
+	//////////////////////////////////////////////////////////////////////////
+	inline bool IsPow2(uint32 value)
+	{
+		return (value != 0) && ((value & (value - 1)) == 0);
+	}
+
+	// Smallest power of 2 greater than or equal to value
+	inline uint32 NextPow2(uint32 value)
+	{
+		uint32 result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+	// Rounds value up to multiple of align (power of 2)
+	inline size_t AlignUp(size_t value, size_t align)
+	{
+		return (value + align - 1) & ~(align - 1);
+	}
+
 
 
 }
@@ -0,0 +1,246 @@
+// The MIT License (MIT)
+//
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+//
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+//
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#include <MTPlatform.h>
+#include <MTTools.h>
+#include <MTAppInterop.h>
+
+
+namespace MT
+{
+	/// \class WorkStealingQueue
+	/// \brief Lock-Free Single-Producer work stealing deque with fixed capacity.
+	///
+	/// Capacity is set at run time, but can't be changed after the queue was created.
+	///
+	/// Owner thread adds and pops items at the bottom (LIFO), any other thread can steal items from the top (FIFO).
+	///
+	/// based on "Dynamic Circular Work-Stealing Deque" by David Chase and Yossi Lev
+	/// and "Correct and Efficient Work-Stealing for Weak Memory Models" by Nhat Minh Le, Antoniu Pop, Albert Cohen, Francesco Zappa Nardelli
+	///
+	template<typename T>
+	class WorkStealingQueue
+	{
+		static const int32 ALIGNMENT = 64;
+
+		T* buffer;
+		uint32 mask;
+		bool isExternalBuffer;
+
+		inline void Dtor(T* element)
+		{
+			MT_UNUSED(element);
+			element->~T();
+		}
+
+		// Prevent false sharing between threads
+		uint8 cacheline0[64];
+
+		// Steal side, modified by thieves and by owner when the last item is popped
+		Atomic32<uint32> top;
+
+		// Prevent false sharing between threads
+		uint8 cacheline1[64];
+
+		// Owner side, modified only by owner thread
+		Atomic32<uint32> bottom;
+
+		// Prevent false sharing between threads
+		uint8 cacheline2[64];
+
+	public:
+
+		MT_NOCOPYABLE(WorkStealingQueue);
+
+		WorkStealingQueue()
+			: buffer(nullptr)
+			, mask(0)
+			, isExternalBuffer(false)
+		{
+			top.StoreRelaxed(0);
+			bottom.StoreRelaxed(0);
+		}
+
+		~WorkStealingQueue()
+		{
+			if (buffer != nullptr)
+			{
+				for (uint32 i = 0; i <= mask; i++)
+				{
+					Dtor(buffer + i);
+				}
+
+				if (isExternalBuffer == false)
+				{
+					Memory::Free(buffer);
+				}
+				buffer = nullptr;
+			}
+		}
+
+		// Size of the storage for the queue of given capacity
+		static size_t GetMemoryRequrementInBytes(uint32 capacity)
+		{
+			return sizeof(T) * capacity;
+		}
+
+		// Queue is just dummy until you call the Create
+		// externalBuffer is optional storage of GetMemoryRequrementInBytes(capacity) bytes, queue does not own it
+		void Create(uint32 capacity, void* externalBuffer = nullptr)
+		{
+			MT_ASSERT(buffer == nullptr, "Queue already created");
+			MT_ASSERT(IsPow2(capacity), "WorkStealingQueue capacity must be power of 2");
+			MT_ASSERT(externalBuffer == nullptr || IsPointerAligned(externalBuffer, ALIGNMENT), "External buffer is not aligned");
+
+			isExternalBuffer = (externalBuffer != nullptr);
+			buffer = isExternalBuffer ? (T*)externalBuffer : (T*)Memory::Alloc(GetMemoryRequrementInBytes(capacity), ALIGNMENT);
+			mask = capacity - 1u;
+			for (uint32 i = 0; i < capacity; i++)
+			{
+				new(buffer + i) T();
+			}
+		}
+
+		bool IsCreated() const
+		{
+			return (buffer != nullptr);
+		}
+
+		// Approximate number of items, exact only if called from owner thread while nobody steals
+		uint32 Size() const
+		{
+			int32 count = (int32)(bottom.Load() - top.Load());
+			return (count > 0) ? (uint32)count : 0;
+		}
+
+		// Returns number of free slots. Owner thread only.
+		uint32 GetFreeSpace() const
+		{
+			// Can be called only by owner thread, so real free space is always greater or equal to this value
+			uint32 count = (bottom.LoadRelaxed() - top.Load());
+			return mask - count;
+		}
+
+		// Owner thread only. Adds all items or nothing.
+		bool Push(const T* itemArray, uint32 count)
+		{
+			MT_VERIFY(buffer, "Can't add items to dummy queue", return false; );
+
+			if (count > GetFreeSpace())
+			{
+				return false;
+			}
+
+			uint32 b = bottom.LoadRelaxed();
+			for (uint32 i = 0; i < count; i++)
+			{
+				buffer[(b + i) & mask] = itemArray[i];
+			}
+
+			// publish items to thieves
+			bottom.Store(b + count);
+			return true;
+		}
+
+		// Owner thread only. Pops newest item.
+		bool TryPop(T & item)
+		{
+			if (buffer == nullptr)
+			{
+				return false;
+			}
+
+			uint32 b = bottom.LoadRelaxed() - 1;
+			bottom.StoreRelaxed(b);
+
+			// bottom must be visible to thieves before the top is read
+			HardwareFullMemoryBarrier();
+
+			uint32 t = top.LoadRelaxed();
+			int32 count = (int32)(b - t);
+			if (count < 0)
+			{
+				// queue is empty, restore bottom
+				bottom.StoreRelaxed(b + 1);
+				return false;
+			}
+
+			item = buffer[b & mask];
+			if (count > 0)
+			{
+				// more than one item left, no conflict with thieves possible
+				return true;
+			}
+
+			// last item in queue, race against thieves
+			bool isWinner = (top.CompareAndSwap(t, t + 1) == t);
+			bottom.StoreRelaxed(b + 1);
+			return isWinner;
+		}
+
+		// Any thread. Pops oldest item.
+		bool TrySteal(T & item)
+		{
+			if (buffer == nullptr)
+			{
+				return false;
+			}
+
+			// top must be read before the bottom, pairs with the barrier in TryPop
+			uint32 t = top.Load();
+			HardwareFullMemoryBarrier();
+			uint32 b = bottom.Load();
+			if ((int32)(b - t) <= 0)
+			{
+				return false;
+			}
+
+			// item can be overwritten only after top is moved, so copy it before CAS
+			item = buffer[t & mask];
+			return (top.CompareAndSwap(t, t + 1) == t);
+		}
+
+		// Any thread. Steals up to half of the items (at least one, but no more than maxCount) starting from the oldest.
+		// Returns the number of stolen items.
+		//
+		// Note: items are claimed one by one. Claiming a range with a single CAS is not safe,
+		// since the owner pops items without CAS while more than one item is left in the queue.
+		uint32 TryStealHalf(T* itemArray, uint32 maxCount)
+		{
+			uint32 count = (Size() + 1) / 2;
+			if (count > maxCount)
+			{
+				count = maxCount;
+			}
+
+			uint32 stolenCount = 0;
+			while (stolenCount < count && TrySteal(itemArray[stolenCount]))
+			{
+				stolenCount++;
+			}
+			return stolenCount;
+		}
+
+	};
+}
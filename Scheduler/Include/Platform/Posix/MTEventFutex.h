@@ -0,0 +1,173 @@
+// The MIT License (MIT)
+// 
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+// 
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+// 
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#ifndef __MT_EVENT_FUTEX__
+#define __MT_EVENT_FUTEX__
+
+#include "MTFutex.h"
+
+#if MT_ENABLE_FUTEX_SYNC
+
+#include <limits.h>
+
+
+namespace MT
+{
+	//
+	// Event based on 32-bit futex word
+	//
+	// Signal makes a syscall only if there are waiting threads.
+	//
+	class EventFutex
+	{
+		static const int32 NOT_SIGNALED = 0;
+		static const int32 SIGNALED = 1;
+
+		// futex word
+		Atomic32<int32> value;
+
+		// number of threads which are sleeping or going to sleep on futex word
+		Atomic32<int32> numOfWaitingThreads;
+
+		EventReset::Type resetType;
+
+		bool isInitialized;
+
+	private:
+
+		bool TryAcquire()
+		{
+			if (resetType == EventReset::MANUAL)
+			{
+				return (value.Load() == SIGNALED);
+			}
+
+			// auto reset: only one waiting thread can take the signal
+			return (value.LoadRelaxed() == SIGNALED && value.CompareAndSwap(SIGNALED, NOT_SIGNALED) == SIGNALED);
+		}
+
+	public:
+
+		MT_NOCOPYABLE(EventFutex);
+
+
+		EventFutex()
+			: isInitialized(false)
+		{
+		}
+
+		EventFutex(EventReset::Type resetType, bool initialState)
+			: isInitialized(false)
+		{
+			Create(resetType, initialState);
+		}
+
+		~EventFutex()
+		{
+			MT_ASSERT(numOfWaitingThreads.Load() == 0, "Event destroyed while threads are waiting");
+		}
+
+		void Create(EventReset::Type _resetType, bool initialState)
+		{
+			MT_ASSERT (!isInitialized, "Event already initialized");
+
+			resetType = _resetType;
+			value.Store(initialState ? SIGNALED : NOT_SIGNALED);
+			numOfWaitingThreads.Store(0);
+			isInitialized = true;
+		}
+
+		void Signal()
+		{
+			MT_ASSERT (isInitialized, "Event not initialized");
+
+			// already signaled, waiters will take the previous signal
+			if (value.CompareAndSwap(NOT_SIGNALED, SIGNALED) != NOT_SIGNALED)
+			{
+				return;
+			}
+
+			// CAS is a full barrier, so waiter can't be missed: it increments counter first and then checks the futex word
+			if (numOfWaitingThreads.Load() > 0)
+			{
+				Futex::Wake(value, (resetType == EventReset::MANUAL) ? INT_MAX : 1);
+			}
+		}
+
+		void Reset()
+		{
+			MT_ASSERT (isInitialized, "Event not initialized");
+			MT_ASSERT(resetType == EventReset::MANUAL, "Can't reset, auto reset event");
+
+			value.Store(NOT_SIGNALED);
+		}
+
+		bool Wait(uint32 milliseconds)
+		{
+			MT_ASSERT (isInitialized, "Event not initialized");
+
+			// early exit if event already signaled
+			if (TryAcquire())
+			{
+				return true;
+			}
+
+			int64 deadline = Futex::GetTimeNanoSeconds() + (int64)milliseconds * 1000000LL;
+
+			numOfWaitingThreads.IncFetch();
+
+			bool isSignaled = false;
+			for(;;)
+			{
+				if (TryAcquire())
+				{
+					isSignaled = true;
+					break;
+				}
+
+				int64 nanoseconds = deadline - Futex::GetTimeNanoSeconds();
+				if (nanoseconds <= 0)
+				{
+					break;
+				}
+
+				struct timespec ts;
+				ts.tv_sec = (time_t)(nanoseconds / 1000000000LL);
+				ts.tv_nsec = (long)(nanoseconds % 1000000000LL);
+
+				// kernel returns immediately if event was signaled after TryAcquire
+				Futex::Wait(value, NOT_SIGNALED, &ts);
+			}
+
+			numOfWaitingThreads.DecFetch();
+			return isSignaled;
+		}
+
+	};
+
+}
+
+#endif
+
+#endif
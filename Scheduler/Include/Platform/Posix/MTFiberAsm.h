@@ -0,0 +1,201 @@
+// The MIT License (MIT)
+// 
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+// 
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+// 
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#ifndef __MT_FIBER_ASM__
+#define __MT_FIBER_ASM__
+
+#include <MTConfig.h>
+
+#if MT_ENABLE_ASM_FIBER_SWITCH
+
+#include <string.h>
+#include <pthread.h>
+
+#include <MTAppInterop.h>
+#include "MTAtomic.h"
+
+
+// Implemented in MTFiberSwitch.cpp
+extern "C"
+{
+	// Saves callee-saved registers to the current stack, stores stack pointer to *fromStackPointer and restores registers from toStackPointer
+	void mt_fiber_switch_context(void** fromStackPointer, void* toStackPointer);
+
+	// First return address of the new fiber, calls r13(r12)
+	void mt_fiber_entry();
+}
+
+
+namespace MT
+{
+
+	//
+	// Linux x86-64 fiber implementation through hand written context switch
+	// Only callee-saved registers, MXCSR and x87 control word are switched, no syscalls.
+	//
+	class FiberAsm
+	{
+		// Default MXCSR (all exceptions masked) and x87 control word (extended precision, all exceptions masked)
+		static const uint64 DEFAULT_FPU_CONTROL_WORDS = 0x1F80ULL | (0x037FULL << 32);
+
+		void* funcData;
+		TThreadEntryPoint func;
+
+		Memory::StackDesc stackDesc;
+
+		// Stack pointer of the suspended fiber
+		void* stackPointer;
+		bool isInitialized;
+		bool isStackOwner;
+
+		static void FiberFuncInternal(void* pFiber)
+		{
+			MT_ASSERT(pFiber != nullptr, "Invalid fiber");
+			FiberAsm* self = (FiberAsm*)pFiber;
+
+			MT_ASSERT(self->isInitialized == true, "Using non initialized fiber");
+
+			MT_ASSERT(self->func != nullptr, "Invalid fiber func");
+			self->func(self->funcData);
+
+			MT_REPORT_ASSERT("Fiber function must never return");
+		}
+
+		void CleanUp()
+		{
+			if (isInitialized)
+			{
+				// Stack memory of the fiber created from the current thread or from external memory is not owned
+				if (isStackOwner)
+				{
+					Memory::FreeStack(stackDesc);
+					isStackOwner = false;
+				}
+
+				isInitialized = false;
+			}
+		}
+
+	public:
+
+		MT_NOCOPYABLE(FiberAsm);
+
+		FiberAsm()
+			: funcData(nullptr)
+			, func(nullptr)
+			, stackPointer(nullptr)
+			, isInitialized(false)
+			, isStackOwner(false)
+		{
+		}
+
+		~FiberAsm()
+		{
+			CleanUp();
+		}
+
+
+		void CreateFromCurrentThreadAndRun(TThreadEntryPoint entryPoint, void *userData)
+		{
+			MT_ASSERT(!isInitialized, "Already initialized");
+
+			func = nullptr;
+			funcData = nullptr;
+
+			// stack pointer will be saved by the first switch from this fiber
+			stackPointer = nullptr;
+			isInitialized = true;
+
+			entryPoint(userData);
+
+			CleanUp();
+		}
+
+
+		void Create(size_t stackSize, TThreadEntryPoint entryPoint, void *userData)
+		{
+			Create(Memory::AllocStack(stackSize), entryPoint, userData);
+			isStackOwner = true;
+		}
+
+		// Fiber on caller's stack memory, memory must outlive the fiber
+		void Create(const Memory::StackDesc& stack, TThreadEntryPoint entryPoint, void *userData)
+		{
+			MT_ASSERT(!isInitialized, "Already initialized");
+			MT_ASSERT(stack.GetStackSize() >= (size_t)PTHREAD_STACK_MIN, "Stack to small");
+
+			func = entryPoint;
+			funcData = userData;
+
+			stackDesc = stack;
+
+			// Initial frame, restored by the first switch to this fiber (see mt_fiber_switch_context)
+			// Stack pointer is 16 bytes aligned after return to mt_fiber_entry, as System V ABI requires before call
+			void** sp = (void**)((uintptr_t)stackDesc.stackTop & ~(uintptr_t)15);
+			*(--sp) = (void*)&mt_fiber_entry;            // return address
+			*(--sp) = nullptr;                           // rbp, terminates frame pointer chain
+			*(--sp) = nullptr;                           // rbx
+			*(--sp) = (void*)this;                       // r12, fiber function argument
+			*(--sp) = (void*)&FiberFuncInternal;         // r13, fiber function
+			*(--sp) = nullptr;                           // r14
+			*(--sp) = nullptr;                           // r15
+			*(--sp) = (void*)DEFAULT_FPU_CONTROL_WORDS;  // MXCSR, x87 control word
+			stackPointer = sp;
+
+			isInitialized = true;
+		}
+
+		// Stack memory of fiber created by Create()
+		const Memory::StackDesc& GetStackDesc() const
+		{
+			return stackDesc;
+		}
+
+#ifdef MT_INSTRUMENTED_BUILD
+		void SetName(const char* fiberName)
+		{
+			MT_UNUSED(fiberName);
+		}
+#endif
+
+		static void SwitchTo(FiberAsm & from, FiberAsm & to)
+		{
+			MT_ASSERT(from.isInitialized, "Invalid from fiber");
+			MT_ASSERT(to.isInitialized, "Invalid to fiber");
+			MT_ASSERT(to.stackPointer != nullptr, "Can't switch to running fiber");
+
+			// No memory barrier here. Fiber migration between threads is synchronized by task queues.
+			void* toStackPointer = to.stackPointer;
+			to.stackPointer = nullptr;
+			mt_fiber_switch_context(&from.stackPointer, toStackPointer);
+		}
+
+	};
+
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+// The MIT License (MIT)
+// 
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+// 
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+// 
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+
+#include <MTConfig.h>
+
+#if MT_ENABLE_ASM_FIBER_SWITCH
+
+//
+// System V AMD64 ABI: rbx, rbp, r12-r15, MXCSR control bits and x87 control word are callee-saved.
+// Everything else is saved by the caller of mt_fiber_switch_context.
+//
+// Saved fiber frame (from lower addresses):  MXCSR | x87 CW | r15 | r14 | r13 | r12 | rbx | rbp | return address
+//
+__asm__(
+	".text\n"
+	".globl mt_fiber_switch_context\n"
+	".hidden mt_fiber_switch_context\n"
+	".type mt_fiber_switch_context,@function\n"
+	".align 16\n"
+"mt_fiber_switch_context:\n"
+	"pushq %rbp\n"
+	"pushq %rbx\n"
+	"pushq %r12\n"
+	"pushq %r13\n"
+	"pushq %r14\n"
+	"pushq %r15\n"
+	"leaq -0x8(%rsp), %rsp\n"
+	"stmxcsr (%rsp)\n"
+	"fnstcw 0x4(%rsp)\n"
+
+	// save current stack pointer (first argument) and switch to the new one (second argument)
+	"movq %rsp, (%rdi)\n"
+	"movq %rsi, %rsp\n"
+
+	"ldmxcsr (%rsp)\n"
+	"fldcw 0x4(%rsp)\n"
+	"leaq 0x8(%rsp), %rsp\n"
+	"popq %r15\n"
+	"popq %r14\n"
+	"popq %r13\n"
+	"popq %r12\n"
+	"popq %rbx\n"
+	"popq %rbp\n"
+	"ret\n"
+	".size mt_fiber_switch_context,.-mt_fiber_switch_context\n"
+
+	".globl mt_fiber_entry\n"
+	".hidden mt_fiber_entry\n"
+	".type mt_fiber_entry,@function\n"
+	".align 16\n"
+"mt_fiber_entry:\n"
+	".cfi_startproc\n"
+	// no return address, stop unwinding here
+	".cfi_undefined rip\n"
+	"movq %r12, %rdi\n"
+	"callq *%r13\n"
+	// fiber function never returns
+	"ud2\n"
+	".cfi_endproc\n"
+	".size mt_fiber_entry,.-mt_fiber_entry\n"
+);
+
+#endif
@@ -0,0 +1,199 @@
+// The MIT License (MIT)
+//
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+//
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+//
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#ifndef __MT_FIBER_UCONTEXT__
+#define __MT_FIBER_UCONTEXT__
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE
+#endif
+
+#include <ucontext.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#ifndef MAP_ANONYMOUS
+    #define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_STACK
+    #define MAP_STACK (0)
+#endif
+
+#include <MTAppInterop.h>
+#include "MTAtomic.h"
+
+
+namespace MT
+{
+
+	//
+	// Fiber implementation through getcontext / makecontext / swapcontext
+	// swapcontext saves and restores signal mask, so every switch is a syscall.
+	//
+	class FiberUContext
+	{
+		void* funcData;
+		TThreadEntryPoint func;
+
+		Memory::StackDesc stackDesc;
+
+		ucontext_t fiberContext;
+		bool isInitialized;
+		bool isStackOwner;
+        
+		static void FiberFuncInternal(void* pFiber)
+		{
+			MT_ASSERT(pFiber != nullptr, "Invalid fiber");
+			FiberUContext* self = (FiberUContext*)pFiber;
+
+			MT_ASSERT(self->isInitialized == true, "Using non initialized fiber");
+
+			MT_ASSERT(self->func != nullptr, "Invalid fiber func");
+			self->func(self->funcData);
+		}
+        
+		void CleanUp()
+		{
+			if (isInitialized)
+			{
+				// Stack memory of the fiber created from the current thread or from external memory is not owned
+				if (isStackOwner)
+				{
+					Memory::FreeStack(stackDesc);
+					isStackOwner = false;
+				}
+
+				isInitialized = false;
+			}
+		}
+
+	public:
+
+		MT_NOCOPYABLE(FiberUContext);
+
+		FiberUContext()
+			: funcData(nullptr)
+			, func(nullptr)
+			, isInitialized(false)
+			, isStackOwner(false)
+		{
+			memset(&fiberContext, 0, sizeof(ucontext_t));
+		}
+
+		~FiberUContext()
+		{
+			CleanUp();
+		}
+
+
+		void CreateFromCurrentThreadAndRun(TThreadEntryPoint entryPoint, void *userData)
+		{
+			MT_ASSERT(!isInitialized, "Already initialized");
+            
+            func = nullptr;
+            funcData = nullptr;
+            
+			// get execution context
+			int res = getcontext(&fiberContext);
+			MT_USED_IN_ASSERT(res);
+			MT_ASSERT(res == 0, "getcontext - failed");
+            
+            isInitialized = true;
+            
+            entryPoint(userData);
+            
+
+			CleanUp();
+		}
+
+
+		void Create(size_t stackSize, TThreadEntryPoint entryPoint, void *userData)
+		{
+			Create(Memory::AllocStack(stackSize), entryPoint, userData);
+			isStackOwner = true;
+		}
+
+		// Fiber on caller's stack memory, memory must outlive the fiber
+		void Create(const Memory::StackDesc& stack, TThreadEntryPoint entryPoint, void *userData)
+		{
+			MT_ASSERT(!isInitialized, "Already initialized");
+			MT_ASSERT(stack.GetStackSize() >= (size_t)PTHREAD_STACK_MIN, "Stack to small");
+
+			func = entryPoint;
+			funcData = userData;
+
+			int res = getcontext(&fiberContext);
+			MT_USED_IN_ASSERT(res);
+			MT_ASSERT(res == 0, "getcontext - failed");
+
+			stackDesc = stack;
+
+			fiberContext.uc_link = nullptr;
+			fiberContext.uc_stack.ss_sp = stackDesc.stackBottom;
+			fiberContext.uc_stack.ss_size = stackDesc.GetStackSize();
+			fiberContext.uc_stack.ss_flags = 0;
+
+			makecontext(&fiberContext, (void(*)())&FiberFuncInternal, 1, (void *)this);
+
+			isInitialized = true;
+		}
+
+		// Stack memory of fiber created by Create()
+		const Memory::StackDesc& GetStackDesc() const
+		{
+			return stackDesc;
+		}
+
+#ifdef MT_INSTRUMENTED_BUILD
+		void SetName(const char* fiberName)
+		{
+			MT_UNUSED(fiberName);
+		}
+#endif
+
+		static void SwitchTo(FiberUContext & from, FiberUContext & to)
+		{
+			HardwareFullMemoryBarrier();
+
+			MT_ASSERT(from.isInitialized, "Invalid from fiber");
+			MT_ASSERT(to.isInitialized, "Invalid to fiber");
+
+			int res = swapcontext(&from.fiberContext, &to.fiberContext);
+			MT_USED_IN_ASSERT(res);
+			MT_ASSERT(res == 0, "setcontext - failed");
+
+		}
+
+
+
+	};
+
+
+}
+
+
+#endif
@@ -0,0 +1,87 @@
+// The MIT License (MIT)
+// 
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+// 
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+// 
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#ifndef __MT_FUTEX__
+#define __MT_FUTEX__
+
+#include <MTConfig.h>
+
+#if MT_ENABLE_FUTEX_SYNC
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+
+#include <Platform/Common/MTAtomic.h>
+
+
+namespace MT
+{
+	namespace Futex
+	{
+		//
+		// Monotonic clock time in nanoseconds, used for wait timeouts
+		//
+		inline int64 GetTimeNanoSeconds()
+		{
+			struct timespec ts;
+			int res = clock_gettime(CLOCK_MONOTONIC, &ts);
+			MT_USED_IN_ASSERT(res);
+			MT_ASSERT(res == 0, "clock_gettime - failed");
+			return (int64)ts.tv_sec * 1000000000LL + (int64)ts.tv_nsec;
+		}
+
+		//
+		// Sleeps while futex word is equal to expectedValue. Spurious wakeups are possible.
+		// Timeout is relative, nullptr means infinite wait. Returns false on timeout.
+		//
+		inline bool Wait(Atomic32Base<int32>& word, int32 expectedValue, const struct timespec* timeout)
+		{
+			long res = syscall(SYS_futex, &word._value, FUTEX_WAIT_PRIVATE, expectedValue, timeout, nullptr, 0);
+			if (res == 0)
+			{
+				return true;
+			}
+
+			MT_ASSERT(errno == EAGAIN || errno == EINTR || errno == ETIMEDOUT, "futex wait - failed");
+			return (errno != ETIMEDOUT);
+		}
+
+		//
+		// Wakes up to count threads sleeping on futex word
+		//
+		inline void Wake(Atomic32Base<int32>& word, int32 count)
+		{
+			long res = syscall(SYS_futex, &word._value, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+			MT_USED_IN_ASSERT(res);
+			MT_ASSERT(res >= 0, "futex wake - failed");
+		}
+	}
+}
+
+#endif
+
+#endif
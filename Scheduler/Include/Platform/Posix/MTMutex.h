@@ -25,71 +25,21 @@
 #ifndef __MT_MUTEX__
 #define __MT_MUTEX__
 
-#include <pthread.h>
+#include <MTConfig.h>
+
+#include "MTMutexPthread.h"
+#include "MTMutexFutex.h"
 
 
 namespace MT
 {
-	class ScopedGuard;
-
-	//
-	//
-	//
-	class Mutex
-	{
-		pthread_mutexattr_t mutexAttr;
-		pthread_mutex_t mutex;
-
-	public:
-
-		MT_NOCOPYABLE(Mutex);
-
-		Mutex()
-		{
-			int res = pthread_mutexattr_init(&mutexAttr);
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == 0, "pthread_mutexattr_init - failed");
-
-			res = pthread_mutexattr_settype(&mutexAttr, PTHREAD_MUTEX_RECURSIVE);
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == 0, "pthread_mutexattr_settype - failed");
-
-			res = pthread_mutex_init(&mutex, &mutexAttr);
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == 0, "pthread_mutex_init - failed");
-		}
-
-		~Mutex()
-		{
-			int res = pthread_mutex_destroy(&mutex);
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == 0, "pthread_mutex_destroy - failed");
-
-			res = pthread_mutexattr_destroy(&mutexAttr);
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == 0, "pthread_mutexattr_destroy - failed");
-		}
-
-		friend class MT::ScopedGuard;
-
-	private:
-
-		void Lock()
-		{
-			int res = pthread_mutex_lock(&mutex);
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == 0, "pthread_mutex_lock - failed");
-		}
-		void Unlock()
-		{
-			int res = pthread_mutex_unlock(&mutex);
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == 0, "pthread_mutex_unlock - failed");
-		}
-
-	};
-
-
+#if MT_ENABLE_FUTEX_SYNC
+	// Linux: futex based adaptive spinning mutex
+	typedef MutexFutex Mutex;
+#else
+	// Recursive pthread mutex
+	typedef MutexPthread Mutex;
+#endif
 }
 
 
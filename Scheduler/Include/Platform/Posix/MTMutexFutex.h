@@ -0,0 +1,170 @@
+// The MIT License (MIT)
+// 
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+// 
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+// 
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+// 
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#pragma once
+
+#ifndef __MT_MUTEX_FUTEX__
+#define __MT_MUTEX_FUTEX__
+
+#include "MTFutex.h"
+
+#if MT_ENABLE_FUTEX_SYNC
+
+#include <pthread.h>
+
+
+namespace MT
+{
+	class ScopedGuard;
+
+	//
+	// Recursive adaptive mutex based on 32-bit futex word
+	//
+	// Contended lock spins for a while before going to sleep. Spin count adapts to the average time needed to acquire the lock.
+	//
+	// based on "Futexes Are Tricky" by Ulrich Drepper (mutex3)
+	//
+	class MutexFutex
+	{
+		static const int32 UNLOCKED = 0;
+		static const int32 LOCKED = 1;
+		static const int32 LOCKED_WITH_WAITERS = 2;
+
+		static const int32 MAX_SPIN_COUNT = 100;
+
+		// futex word
+		Atomic32<int32> state;
+
+		// spin count estimation, read by contending threads and updated by lock owner only
+		Atomic32<int32> spinCount;
+
+		// owner thread, used for recursive locking
+		AtomicPtr<void> owner;
+		uint32 recursionCount;
+
+		static void* GetCurrentThreadTag()
+		{
+			return (void*)pthread_self();
+		}
+
+		// Lock owner only
+		void UpdateSpinCount(int32 iteration)
+		{
+			int32 oldSpinCount = spinCount.LoadRelaxed();
+			spinCount.StoreRelaxed(oldSpinCount + (iteration - oldSpinCount) / 8);
+		}
+
+		void LockSlow()
+		{
+			int32 maxSpinCount = spinCount.LoadRelaxed() * 2 + 10;
+			if (maxSpinCount > MAX_SPIN_COUNT)
+			{
+				maxSpinCount = MAX_SPIN_COUNT;
+			}
+
+			int32 iteration = 0;
+			for(; iteration < maxSpinCount; iteration++)
+			{
+				YieldProcessor();
+				if (state.LoadRelaxed() == UNLOCKED && state.CompareAndSwap(UNLOCKED, LOCKED) == UNLOCKED)
+				{
+					UpdateSpinCount(iteration);
+					return;
+				}
+			}
+
+			// mark mutex as contended and sleep until it is unlocked
+			while (state.Exchange(LOCKED_WITH_WAITERS) != UNLOCKED)
+			{
+				Futex::Wait(state, LOCKED_WITH_WAITERS, nullptr);
+			}
+
+			UpdateSpinCount(iteration);
+		}
+
+	public:
+
+		MT_NOCOPYABLE(MutexFutex);
+
+		MutexFutex()
+			: recursionCount(0)
+		{
+			spinCount.StoreRelaxed(0);
+			state.Store(UNLOCKED);
+			owner.Store(nullptr);
+		}
+
+		~MutexFutex()
+		{
+			MT_ASSERT(state.Load() == UNLOCKED, "Mutex destroyed while locked");
+		}
+
+		friend class MT::ScopedGuard;
+
+	private:
+
+		void Lock()
+		{
+			void* self = GetCurrentThreadTag();
+			if (owner.LoadRelaxed() == self)
+			{
+				recursionCount++;
+				return;
+			}
+
+			if (state.CompareAndSwap(UNLOCKED, LOCKED) != UNLOCKED)
+			{
+				LockSlow();
+			}
+
+			owner.StoreRelaxed(self);
+			recursionCount = 1;
+		}
+
+		void Unlock()
+		{
+			MT_ASSERT(owner.LoadRelaxed() == GetCurrentThreadTag(), "Mutex unlocked by non owner thread");
+
+			recursionCount--;
+			if (recursionCount > 0)
+			{
+				return;
+			}
+
+			owner.StoreRelaxed(nullptr);
+
+			// wake up one of the sleeping threads only if there are any
+			if (state.DecFetch() != UNLOCKED)
+			{
+				state.Store(UNLOCKED);
+				Futex::Wake(state, 1);
+			}
+		}
+
+	};
+
+
+}
+
+#endif
+
+#endif
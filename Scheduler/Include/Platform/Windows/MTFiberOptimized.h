@@ -47,6 +47,7 @@ namespace MT
 		Memory::StackDesc stackDesc;
 
 		bool isInitialized;
+		bool isStackOwner;
 
 #if MT_PTR64
 		// https://en.wikipedia.org/wiki/X86_calling_conventions#Microsoft_x64_calling_convention
@@ -75,10 +76,11 @@ namespace MT
 		{
 			if (isInitialized)
 			{
-				// if func != null than we have stack memory ownership
-				if (func != nullptr)
+				// Stack memory of the fiber created from the current thread or from external memory is not owned
+				if (isStackOwner)
 				{
 					Memory::FreeStack(stackDesc);
+					isStackOwner = false;
 				}
 
 				isInitialized = false;
@@ -94,6 +96,7 @@ namespace MT
 			: funcData(nullptr)
 			, func(nullptr)
 			, isInitialized(false)
+			, isStackOwner(false)
 		{
 #if MT_PTR64
 			MT_ASSERT(IsPointerAligned( this, 16 ), "Fiber must be aligned by 16 bytes");
@@ -131,6 +134,13 @@ namespace MT
 		}
 
 		void Create(size_t stackSize, TThreadEntryPoint entryPoint, void* userData)
+		{
+			Create(Memory::AllocStack(stackSize), entryPoint, userData);
+			isStackOwner = true;
+		}
+
+		// Fiber on caller's stack memory, memory must outlive the fiber
+		void Create(const Memory::StackDesc& stack, TThreadEntryPoint entryPoint, void* userData)
 		{
 			MT_ASSERT(!isInitialized, "Already initialized");
 
@@ -142,7 +152,7 @@ namespace MT
 			MT_USED_IN_ASSERT(res);
 			MT_ASSERT(res != 0, "GetThreadContext - failed");
 
-			stackDesc = Memory::AllocStack(stackSize);
+			stackDesc = stack;
 
 			void (*pFunc)() = (void(*)())&FiberFuncInternal;
 
@@ -180,6 +190,12 @@ namespace MT
 			isInitialized = true;
 		}
 
+		// Stack memory of fiber created by Create()
+		const Memory::StackDesc& GetStackDesc() const
+		{
+			return stackDesc;
+		}
+
 #ifdef MT_INSTRUMENTED_BUILD
 		void SetName(const char* fiberName)
 		{
@@ -64,6 +64,9 @@ typedef CONTEXT MW_CONTEXT;
 #define MW_PAGE_READWRITE (PAGE_READWRITE)
 #define MW_PAGE_NOACCESS (PAGE_NOACCESS)
 #define MW_MEM_RELEASE (MEM_RELEASE)
+#define MW_MEM_RESET (MEM_RESET)
+#define MW_MEM_RESERVE (MEM_RESERVE)
+#define MW_MEM_LARGE_PAGES (MEM_LARGE_PAGES)
 #define MW_ERROR_TIMEOUT (ERROR_TIMEOUT)
 
 #define MW_CURRENT_FIBER_OFFSET (FIELD_OFFSET(NT_TIB, FiberData))
@@ -220,6 +223,9 @@ struct MW_CONTEXT
 #define MW_PAGE_READWRITE (0x04)
 #define MW_PAGE_NOACCESS (0x01)
 #define MW_MEM_RELEASE (0x8000)
+#define MW_MEM_RESET (0x80000)
+#define MW_MEM_RESERVE (0x2000)
+#define MW_MEM_LARGE_PAGES (0x20000000)
 #define MW_ERROR_TIMEOUT (1460L)
 
 #define MW_THREAD_PRIORITY_HIGHEST (2) 
@@ -293,6 +299,7 @@ MW_WINBASEAPI MW_BOOL MW_WINAPI SetThreadContext( MW_HANDLE hThread, const MW_CO
 MW_WINBASEAPI void* MW_WINAPI VirtualAlloc( void* lpAddress, size_t dwSize, MW_DWORD flAllocationType, MW_DWORD flProtect );
 MW_WINBASEAPI MW_BOOL MW_WINAPI VirtualProtect( void* lpAddress, size_t dwSize, MW_DWORD flNewProtect, MW_DWORD* lpflOldProtect );
 MW_WINBASEAPI MW_BOOL MW_WINAPI VirtualFree( void* lpAddress, size_t dwSize, MW_DWORD dwFreeType );
+MW_WINBASEAPI size_t MW_WINAPI GetLargePageMinimum();
 
 
 MW_WINBASEAPI void MW_WINAPI DeleteFiber( void* lpFiber );
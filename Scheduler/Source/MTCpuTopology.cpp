@@ -0,0 +1,258 @@
+// The MIT License (MIT)
+//
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+//
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+//
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#include <MTCpuTopology.h>
+#include <MTAppInterop.h>
+
+#if MT_PLATFORM_POSIX
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+namespace MT
+{
+
+#if MT_PLATFORM_POSIX
+
+	// Reads the first unsigned number from sysfs file. Also works for cpu lists like "0-3,8-11"
+	static bool ReadSysNumber(const char* path, uint32 & value)
+	{
+		FILE* file = fopen(path, "r");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		unsigned int number = 0;
+		int res = fscanf(file, "%u", &number);
+		fclose(file);
+
+		if (res != 1)
+		{
+			return false;
+		}
+
+		value = (uint32)number;
+		return true;
+	}
+
+	static bool QueryNodeId(uint32 cpuIndex, uint32 & nodeId)
+	{
+		char path[128];
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpuIndex);
+
+		DIR* dir = opendir(path);
+		if (dir == nullptr)
+		{
+			return false;
+		}
+
+		bool isFound = false;
+		while (struct dirent* entry = readdir(dir))
+		{
+			unsigned int number = 0;
+			if (sscanf(entry->d_name, "node%u", &number) == 1)
+			{
+				nodeId = (uint32)number;
+				isFound = true;
+				break;
+			}
+		}
+
+		closedir(dir);
+		return isFound;
+	}
+
+	static bool QueryLastLevelCacheId(uint32 cpuIndex, uint32 & cacheId)
+	{
+		char path[128];
+
+		uint32 lastLevel = 0;
+		for (uint32 cacheIndex = 0; ; cacheIndex++)
+		{
+			uint32 level = 0;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpuIndex, cacheIndex);
+			if (!ReadSysNumber(path, level))
+			{
+				break;
+			}
+
+			if (level < lastLevel)
+			{
+				continue;
+			}
+
+			// Cache is identified by the first processor which shares it
+			uint32 firstCpu = 0;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpuIndex, cacheIndex);
+			if (ReadSysNumber(path, firstCpu))
+			{
+				lastLevel = level;
+				cacheId = firstCpu;
+			}
+		}
+
+		return (lastLevel > 0);
+	}
+
+	bool CpuTopology::QueryPlatformTopology()
+	{
+		long configuredCpusCount = sysconf(_SC_NPROCESSORS_CONF);
+		if (configuredCpusCount <= 0)
+		{
+			return false;
+		}
+
+		cpusCount = (uint32)configuredCpusCount;
+		cpus = (CpuInfo*)Memory::Alloc(sizeof(CpuInfo) * cpusCount);
+
+		bool isAnyValid = false;
+		char path[128];
+		for (uint32 cpuIndex = 0; cpuIndex < cpusCount; cpuIndex++)
+		{
+			CpuInfo & cpu = cpus[cpuIndex];
+			cpu.isValid = false;
+
+			uint32 packageId = 0;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpuIndex);
+			if (!ReadSysNumber(path, packageId))
+			{
+				continue;
+			}
+
+			uint32 coreId = 0;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpuIndex);
+			if (!ReadSysNumber(path, coreId))
+			{
+				continue;
+			}
+
+			// core_id is unique only inside the package
+			cpu.coreId = (packageId << 16) | (coreId & 0xFFFF);
+
+			// Without cache information only hardware threads of the same core are considered as close
+			if (!QueryLastLevelCacheId(cpuIndex, cpu.cacheId))
+			{
+				cpu.cacheId = 0x80000000 | cpu.coreId;
+			}
+
+			// Kernel without NUMA support, assume one node per package
+			if (!QueryNodeId(cpuIndex, cpu.nodeId))
+			{
+				cpu.nodeId = packageId;
+			}
+
+			cpu.isValid = true;
+			isAnyValid = true;
+		}
+
+		return isAnyValid;
+	}
+
+#else
+
+	bool CpuTopology::QueryPlatformTopology()
+	{
+		return false;
+	}
+
+#endif
+
+
+	CpuTopology::CpuTopology()
+		: cpus(nullptr)
+		, cpusCount(0)
+	{
+	}
+
+	CpuTopology::~CpuTopology()
+	{
+		if (cpus != nullptr)
+		{
+			Memory::Free(cpus);
+			cpus = nullptr;
+		}
+		cpusCount = 0;
+	}
+
+	bool CpuTopology::Query()
+	{
+		if (cpus != nullptr)
+		{
+			Memory::Free(cpus);
+			cpus = nullptr;
+		}
+		cpusCount = 0;
+
+		return QueryPlatformTopology();
+	}
+
+	uint32 CpuTopology::GetCpuCount() const
+	{
+		return cpusCount;
+	}
+
+	StealDistance::Type CpuTopology::GetDistance(uint32 cpuA, uint32 cpuB) const
+	{
+		if (cpuA >= cpusCount || cpuB >= cpusCount)
+		{
+			return StealDistance::REMOTE;
+		}
+
+		const CpuInfo & a = cpus[cpuA];
+		const CpuInfo & b = cpus[cpuB];
+		if (!a.isValid || !b.isValid)
+		{
+			return StealDistance::REMOTE;
+		}
+
+		if (a.coreId == b.coreId)
+		{
+			return StealDistance::SMT_SIBLING;
+		}
+
+		if (a.cacheId == b.cacheId)
+		{
+			return StealDistance::SHARED_CACHE;
+		}
+
+		if (a.nodeId == b.nodeId)
+		{
+			return StealDistance::SAME_NODE;
+		}
+
+		return StealDistance::REMOTE;
+	}
+
+	uint32 CpuTopology::GetNodeId(uint32 cpu) const
+	{
+		if (cpu >= cpusCount || !cpus[cpu].isValid)
+		{
+			return MT_NUMA_NODE_ANY;
+		}
+
+		return cpus[cpu].nodeId;
+	}
+
+}
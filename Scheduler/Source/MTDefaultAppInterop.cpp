@@ -24,6 +24,7 @@
 #include <MTTools.h>
 
 #include <stdio.h>
+#include <errno.h>
 
 #if MT_SSE_INTRINSICS_SUPPORTED
 #include <xmmintrin.h>
@@ -42,6 +43,8 @@ inline void ThrowException()
 #elif MT_PLATFORM_POSIX
 
 #include<signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 inline void ThrowException()
 {
 	raise(SIGTRAP);
@@ -139,8 +142,14 @@ namespace MT
 		//protected guard page
 		pagesCount++;
 
+		// Physical pages are committed on first touch. Do not reserve swap space for the whole stack either.
+		int mapFlags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK;
+#ifdef MAP_NORESERVE
+		mapFlags |= MAP_NORESERVE;
+#endif
+
 		desc.stackMemoryBytesCount = pagesCount * pageSize;
-		desc.stackMemory = (char*)mmap(NULL, desc.stackMemoryBytesCount, PROT_READ | PROT_WRITE,  MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+		desc.stackMemory = (char*)mmap(NULL, desc.stackMemoryBytesCount, PROT_READ | PROT_WRITE, mapFlags, -1, 0);
 
 		MT_ASSERT((void *)desc.stackMemory != (void *)-1, "Can't allocate memory");
 
@@ -175,6 +184,160 @@ namespace MT
 #endif
 	}
 
+	void Memory::ReleaseStackPages(const Memory::StackDesc & desc, size_t usedBytes)
+	{
+		size_t stackSize = (char*)desc.stackTop - (char*)desc.stackBottom;
+		if (usedBytes >= stackSize)
+		{
+			return;
+		}
+
+#if MT_PLATFORM_WINDOWS 
+
+		MW_SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		size_t pageSize = systemInfo.dwPageSize;
+
+#elif MT_PLATFORM_POSIX || MT_PLATFORM_OSX
+
+		size_t pageSize = (size_t)sysconf(_SC_PAGE_SIZE);
+
+#else
+		#error Platform is not supported!
+#endif
+
+		// Stack bottom is page aligned, round the end down to keep the used pages untouched
+		char* releaseBegin = (char*)desc.stackBottom;
+		char* releaseEnd = (char*)((uintptr_t)((char*)desc.stackTop - usedBytes) & ~(uintptr_t)(pageSize - 1));
+		if (releaseEnd <= releaseBegin)
+		{
+			return;
+		}
+
+#if MT_PLATFORM_WINDOWS 
+
+		// Pages stay committed, but the system can drop them without writing to the page file.
+		// Large pages can't be reset, so the result is ignored.
+		VirtualAlloc(releaseBegin, releaseEnd - releaseBegin, MW_MEM_RESET, MW_PAGE_READWRITE);
+
+#else
+
+		// Explicit huge pages can be released only as a whole
+		int res = madvise(releaseBegin, releaseEnd - releaseBegin, MADV_DONTNEED);
+		MT_USED_IN_ASSERT(res);
+		MT_ASSERT(res == 0 || errno == EINVAL, "Can't release memory");
+
+#endif
+	}
+
+	Memory::StackDesc Memory::AllocHugePages(size_t size)
+	{
+		StackDesc desc;
+
+#if MT_PLATFORM_WINDOWS 
+
+		// Large pages require SeLockMemoryPrivilege and can't have a guard page
+		size_t largePageSize = GetLargePageMinimum();
+		if (largePageSize > 0)
+		{
+			size_t bytesCount = AlignUp(size, largePageSize);
+			desc.stackMemory = (char*)VirtualAlloc(NULL, bytesCount, MW_MEM_RESERVE | MW_MEM_COMMIT | MW_MEM_LARGE_PAGES, MW_PAGE_READWRITE);
+			if (desc.stackMemory != NULL)
+			{
+				desc.stackMemoryBytesCount = bytesCount;
+				desc.stackBottom = desc.stackMemory;
+				desc.stackTop = desc.stackMemory + size;
+				return desc;
+			}
+		}
+
+		return AllocStack(size);
+
+#elif MT_PLATFORM_POSIX || MT_PLATFORM_OSX
+
+		static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+		size_t pageSize = (size_t)sysconf(_SC_PAGE_SIZE);
+		size_t bytesCount = AlignUp(size, HUGE_PAGE_SIZE);
+
+#ifdef MAP_HUGETLB
+		// Explicit huge pages are available only if reserved by administrator (vm.nr_hugepages). Guard page would take a whole huge page.
+		void* hugeMemory = mmap(NULL, bytesCount, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (hugeMemory != MAP_FAILED)
+		{
+			desc.stackMemory = (char*)hugeMemory;
+			desc.stackMemoryBytesCount = bytesCount;
+			desc.stackBottom = desc.stackMemory;
+			desc.stackTop = desc.stackMemory + size;
+			return desc;
+		}
+#endif
+
+		// Transparent huge pages. Extra huge page is reserved to align the usable range, guard page is right below it.
+		int mapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+		mapFlags |= MAP_NORESERVE;
+#endif
+
+		desc.stackMemoryBytesCount = bytesCount + HUGE_PAGE_SIZE;
+		desc.stackMemory = (char*)mmap(NULL, desc.stackMemoryBytesCount, PROT_READ | PROT_WRITE, mapFlags, -1, 0);
+		MT_ASSERT((void *)desc.stackMemory != (void *)-1, "Can't allocate memory");
+
+		char* bottom = (char*)AlignUp((size_t)desc.stackMemory + pageSize, HUGE_PAGE_SIZE);
+		desc.stackBottom = bottom;
+		desc.stackTop = bottom + size;
+
+		int res = mprotect(bottom - pageSize, pageSize, PROT_NONE);
+		MT_USED_IN_ASSERT(res);
+		MT_ASSERT(res == 0, "Can't protect memory");
+
+#ifdef MADV_HUGEPAGE
+		// Fails if transparent huge pages are disabled, regular pages are used then
+		madvise(bottom, bytesCount, MADV_HUGEPAGE);
+#endif
+
+		return desc;
+
+#else
+		#error Platform is not supported!
+#endif
+	}
+
+	void Memory::FreeHugePages(const Memory::StackDesc & desc)
+	{
+		FreeStack(desc);
+	}
+
+	void Memory::BindToNode(void* p, size_t size, uint32 nodeId)
+	{
+#if MT_PLATFORM_POSIX && defined(SYS_mbind)
+
+		// Memory policy constants from linux/mempolicy.h, libnuma is not required
+		static const int MPOL_PREFERRED_MODE = 1;
+		static const unsigned MPOL_MF_MOVE_FLAG = (1 << 1);
+		static const uint32 MAX_NODES_COUNT = 1024;
+		static const uint32 BITS_PER_WORD = sizeof(unsigned long) * 8;
+
+		if (nodeId >= MAX_NODES_COUNT || size == 0)
+		{
+			return;
+		}
+
+		unsigned long nodeMask[MAX_NODES_COUNT / BITS_PER_WORD] = { 0 };
+		nodeMask[nodeId / BITS_PER_WORD] = 1UL << (nodeId % BITS_PER_WORD);
+
+		// Fails if node is offline or kernel is built without NUMA support, default policy is kept then
+		syscall(SYS_mbind, p, size, MPOL_PREFERRED_MODE, nodeMask, (unsigned long)MAX_NODES_COUNT + 1, MPOL_MF_MOVE_FLAG);
+
+#else
+
+		// Pages stay on the node of the first touching thread (Windows VirtualAllocExNuma works for new allocations only)
+		MT_UNUSED(p);
+		MT_UNUSED(size);
+		MT_UNUSED(nodeId);
+
+#endif
+	}
+
 	void Diagnostic::ReportAssert(const char* condition, const char* description, const char* sourceFile, int sourceLine)
 	{
 		printf("Assertion failed : %s. File %s, line %d. Condition %s\n", description, sourceFile, sourceLine, condition);
@@ -27,10 +27,18 @@ namespace MT
 	FiberContext::FiberContext()
 		: threadContext(nullptr)
 		, taskStatus(FiberTaskStatus::UNKNOWN)
+		, currentCounter(nullptr)
 		, stackRequirements(StackRequirements::INVALID)
 		, childrenFibersCount(0)
 		, parentFiber(nullptr)
+		, readyParentFiber(nullptr)
+		, nextWaitingFiber(nullptr)
+		, waitTargetValue(0)
 		, fiberIndex(UINT_MAX)
+		, hasResidentStack(false)
+		, idleStartTime(0)
+		, idleStackPointer(nullptr)
+		, nodeIndex(0)
 	{
 		
 	}
@@ -66,30 +74,18 @@ namespace MT
 	{
 		MT_ASSERT(childrenFibersCount.Load() == 0, "Can't release fiber with active children fibers");
 		currentTask = internal::TaskDesc();
+		currentCounter = nullptr;
 		parentFiber = nullptr;
+		readyParentFiber = nullptr;
 		threadContext = nullptr;
 		stackRequirements = StackRequirements::INVALID;
 	}
 
 	void FiberContext::Yield()
 	{
-		taskStatus = FiberTaskStatus::YIELDED;
+		MT_ASSERT(stackRequirements != StackRequirements::STACKLESS, "Stackless task can't yield. Use StackRequirements::STANDARD instead.");
 
-		Fiber & schedulerFiber = threadContext->schedulerFiber;
-
-#ifdef MT_INSTRUMENTED_BUILD		
-		threadContext->NotifyTaskExecuteStateChanged( currentTask.debugColor, currentTask.debugID, TaskExecuteState::SUSPEND, (int32)fiberIndex);
-#endif
-
-		// Yielding, so reset thread context
-		threadContext = nullptr;
-
-		//switch to scheduler
-		Fiber::SwitchTo(fiber, schedulerFiber);
-
-#ifdef MT_INSTRUMENTED_BUILD
-		threadContext->NotifyTaskExecuteStateChanged( currentTask.debugColor, currentTask.debugID, TaskExecuteState::RESUME, (int32)fiberIndex);
-#endif
+		SuspendAndYield(FiberTaskStatus::YIELDED);
 	}
 
 	void FiberContext::RunSubtasksAndYieldImpl(ArrayView<internal::TaskBucket>& buckets)
@@ -98,15 +94,74 @@ namespace MT
 		MT_ASSERT(threadContext->taskScheduler, "Sanity check failed!");
 		MT_ASSERT(threadContext->taskScheduler->IsWorkerThread(), "Can't use RunSubtasksAndYield outside Task. Use TaskScheduler.WaitGroup() instead.");
 		MT_ASSERT(threadContext->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+		MT_ASSERT(stackRequirements != StackRequirements::STACKLESS, "Stackless task can't wait for subtasks. Use StackRequirements::STANDARD instead.");
 
 		// add to scheduler
-		threadContext->taskScheduler->RunTasksImpl(buckets, this, false);
+		threadContext->taskScheduler->RunTasksImpl(buckets, this, false, threadContext, nullptr);
 
 		//
 		MT_ASSERT(threadContext->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
 
+		SuspendAndYield(FiberTaskStatus::AWAITING_CHILD);
+	}
+
+
+	void FiberContext::WaitGroupAndYield(TaskGroup group)
+	{
+		MT_ASSERT(threadContext, "ThreadContext is nullptr");
+		MT_ASSERT(threadContext->taskScheduler, "Sanity check failed!");
+		MT_ASSERT(threadContext->taskScheduler->IsWorkerThread(), "Can't use WaitGroupAndYield outside Task. Use TaskScheduler.WaitGroup() instead.");
+		MT_ASSERT(threadContext->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+		MT_ASSERT(stackRequirements != StackRequirements::STACKLESS, "Stackless task can't wait for group. Use StackRequirements::STANDARD instead.");
+		MT_ASSERT(group != currentGroup, "Task can't wait for its own group");
+
+		TaskScheduler& scheduler = *(threadContext->taskScheduler);
+
+		// Early exit if no tasks in group
+		if (scheduler.GetGroupDesc(group).GetTaskCount() == 0)
+		{
+			return;
+		}
+
+		// Fiber is resumed by the thread which drops the last wait token. Scheduler holds one more token until this fiber is suspended.
+		childrenFibersCount.IncFetch();
+		scheduler.AddGroupWaiter(group, this);
+
+		SuspendAndYield(FiberTaskStatus::AWAITING_GROUP);
+	}
+
+
+	void FiberContext::WaitCounterAndYield(TaskCounter& counter, int32 targetValue)
+	{
+		MT_ASSERT(threadContext, "ThreadContext is nullptr");
+		MT_ASSERT(threadContext->taskScheduler, "Sanity check failed!");
+		MT_ASSERT(threadContext->taskScheduler->IsWorkerThread(), "Can't use WaitCounterAndYield outside Task.");
+		MT_ASSERT(threadContext->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+		MT_ASSERT(stackRequirements != StackRequirements::STACKLESS, "Stackless task can't wait for counter. Use StackRequirements::STANDARD instead.");
+		MT_ASSERT(&counter != currentCounter, "Task can't wait for its own counter");
+
+		// Early exit if target is already reached
+		if (counter.GetValue() <= targetValue)
+		{
+			return;
+		}
+
+		// Fiber is resumed by the thread which drops the last wait token, the same way as in WaitGroupAndYield
+		waitTargetValue = targetValue;
+		childrenFibersCount.IncFetch();
+		threadContext->taskScheduler->AddCounterWaiter(counter, this);
+
+		SuspendAndYield(FiberTaskStatus::AWAITING_COUNTER);
+	}
+
+
+	void FiberContext::SuspendAndYield(FiberTaskStatus::Type status)
+	{
+		MT_ASSERT(threadContext, "ThreadContext is nullptr");
+		MT_ASSERT(threadContext->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+
 		// Change status
-		taskStatus = FiberTaskStatus::AWAITING_CHILD;
+		taskStatus = status;
 
 		Fiber & schedulerFiber = threadContext->schedulerFiber;
 
@@ -123,15 +178,14 @@ namespace MT
 #ifdef MT_INSTRUMENTED_BUILD
 		threadContext->NotifyTaskExecuteStateChanged( currentTask.debugColor, currentTask.debugID, TaskExecuteState::RESUME, (int32)fiberIndex);
 #endif
-
 	}
 
 
-	void FiberContext::RunAsync(TaskGroup taskGroup, const TaskHandle* taskHandleArray, uint32 taskHandleCount)
+	void FiberContext::RunAsync(TaskGroup taskGroup, const TaskHandle* taskHandleArray, uint32 taskHandleCount, TaskCounter* counter)
 	{
-		MT_ASSERT(taskHandleCount < (internal::TASK_BUFFER_CAPACITY - 1), "Too many tasks per one Run.");
 		MT_ASSERT(threadContext, "ThreadContext is nullptr");
 		MT_ASSERT(threadContext->taskScheduler, "Sanity check failed!");
+		MT_ASSERT(taskHandleCount < (threadContext->taskScheduler->GetTaskQueueCapacity() - 1), "Too many tasks per one Run.");
 		MT_ASSERT(threadContext->taskScheduler->IsWorkerThread(), "Can't use RunAsync outside Task. Use TaskScheduler.RunAsync() instead.");
 
 		TaskScheduler& scheduler = *(threadContext->taskScheduler);
@@ -142,15 +196,15 @@ namespace MT
 		ArrayView<internal::TaskBucket>	buckets(MT_ALLOCATE_ON_STACK(sizeof(internal::TaskBucket) * bucketCount), bucketCount);
 
 		internal::DistibuteDescriptions(taskGroup, taskHandleArray, buffer, buckets);
-		scheduler.RunTasksImpl(buckets, nullptr, false);
+		scheduler.RunTasksImpl(buckets, nullptr, false, threadContext, counter);
 	}
 
 
 	void FiberContext::RunSubtasksAndYield(TaskGroup taskGroup, const TaskHandle* taskHandleArray, uint32 taskHandleCount)
 	{
-		MT_ASSERT(taskHandleCount < (internal::TASK_BUFFER_CAPACITY - 1), "Too many tasks per one Run.");
 		MT_ASSERT(threadContext, "ThreadContext is nullptr");
 		MT_ASSERT(threadContext->taskScheduler, "TaskScheduler is nullptr");
+		MT_ASSERT(taskHandleCount < (threadContext->taskScheduler->GetTaskQueueCapacity() - 1), "Too many tasks per one Run.");
 
 		TaskScheduler& scheduler = *(threadContext->taskScheduler);
 
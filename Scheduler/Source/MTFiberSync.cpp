@@ -0,0 +1,359 @@
+// The MIT License (MIT)
+//
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+//
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+//
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#include <MTScheduler.h>
+
+namespace MT
+{
+	namespace internal
+	{
+		FiberWaitList::FiberWaitList()
+			: head(nullptr)
+			, tail(nullptr)
+			, scheduler(nullptr)
+		{
+		}
+
+		FiberWaitList::~FiberWaitList()
+		{
+			MT_ASSERT(head == nullptr, "Synchronization primitive is destroyed while fibers are waiting for it");
+		}
+
+		void FiberWaitList::Push(FiberContext& fiberContext)
+		{
+			internal::ThreadContext* threadContext = fiberContext.GetThreadContext();
+			MT_ASSERT(threadContext, "ThreadContext is nullptr");
+			MT_ASSERT(threadContext->taskScheduler->IsWorkerThread(), "Can't wait for synchronization primitive outside Task.");
+			MT_ASSERT(fiberContext.stackRequirements != StackRequirements::STACKLESS, "Stackless task can't be suspended. Use StackRequirements::STANDARD instead.");
+			MT_ASSERT(scheduler == nullptr || scheduler == threadContext->taskScheduler, "Synchronization primitive can't be shared between schedulers");
+			scheduler = threadContext->taskScheduler;
+
+			// Fiber is resumed by the thread which drops the last wait token. Scheduler holds one more token until this fiber is suspended.
+			fiberContext.childrenFibersCount.IncFetch();
+
+			fiberContext.nextWaitingFiber = nullptr;
+			if (tail != nullptr)
+			{
+				tail->nextWaitingFiber = &fiberContext;
+			} else
+			{
+				head = &fiberContext;
+			}
+			tail = &fiberContext;
+		}
+
+		FiberContext* FiberWaitList::Pop()
+		{
+			FiberContext* fiberContext = head;
+			if (fiberContext == nullptr)
+			{
+				return nullptr;
+			}
+
+			head = fiberContext->nextWaitingFiber;
+			if (head == nullptr)
+			{
+				tail = nullptr;
+			}
+
+			fiberContext->nextWaitingFiber = nullptr;
+			return fiberContext;
+		}
+
+		FiberContext* FiberWaitList::PopAll()
+		{
+			FiberContext* fiberContext = head;
+			head = nullptr;
+			tail = nullptr;
+			return fiberContext;
+		}
+
+		void FiberWaitList::Resume(TaskScheduler* scheduler, FiberContext* fiberContext)
+		{
+			while (fiberContext != nullptr)
+			{
+				// Resumed fiber can wait for something else right away, so the link must be read first
+				FiberContext* nextFiberContext = fiberContext->nextWaitingFiber;
+				fiberContext->nextWaitingFiber = nullptr;
+
+				if (fiberContext->childrenFibersCount.DecFetch() == 0)
+				{
+					MT_ASSERT(scheduler, "Sanity check failed!");
+					scheduler->ResumeAwaitingFiber(fiberContext);
+				}
+
+				fiberContext = nextFiberContext;
+			}
+		}
+
+		void FiberWaitList::Suspend(FiberContext& fiberContext)
+		{
+			fiberContext.SuspendAndYield(FiberTaskStatus::AWAITING_SYNC);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	FiberMutex::FiberMutex()
+		: isLocked(false)
+	{
+	}
+
+	void FiberMutex::Lock(FiberContext& fiberContext)
+	{
+		spinLock.Lock();
+		if (isLocked == false)
+		{
+			isLocked = true;
+			spinLock.Unlock();
+			return;
+		}
+
+		// Unlock hands the mutex over, fiber owns it when resumed
+		waiters.Push(fiberContext);
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Suspend(fiberContext);
+	}
+
+	bool FiberMutex::TryLock()
+	{
+		spinLock.Lock();
+		bool isAcquired = (isLocked == false);
+		isLocked = true;
+		spinLock.Unlock();
+		return isAcquired;
+	}
+
+	void FiberMutex::Unlock()
+	{
+		spinLock.Lock();
+		MT_ASSERT(isLocked, "Mutex is not locked");
+		FiberContext* nextOwner = waiters.Pop();
+		TaskScheduler* scheduler = waiters.GetScheduler();
+		if (nextOwner == nullptr)
+		{
+			isLocked = false;
+		}
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Resume(scheduler, nextOwner);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	FiberSemaphore::FiberSemaphore(int32 initialCount)
+		: count(initialCount)
+	{
+		MT_ASSERT(initialCount >= 0, "Invalid semaphore count");
+	}
+
+	void FiberSemaphore::Acquire(FiberContext& fiberContext)
+	{
+		spinLock.Lock();
+		if (count > 0)
+		{
+			count--;
+			spinLock.Unlock();
+			return;
+		}
+
+		// Release hands the unit over, fiber owns it when resumed
+		waiters.Push(fiberContext);
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Suspend(fiberContext);
+	}
+
+	bool FiberSemaphore::TryAcquire()
+	{
+		spinLock.Lock();
+		bool isAcquired = (count > 0);
+		if (isAcquired)
+		{
+			count--;
+		}
+		spinLock.Unlock();
+		return isAcquired;
+	}
+
+	void FiberSemaphore::Release(int32 releaseCount)
+	{
+		MT_ASSERT(releaseCount > 0, "Invalid release count");
+
+		// Units are handed over to waiters in one pass, semaphore is not touched after the first waiter is resumed
+		FiberContext* nextOwners = nullptr;
+		FiberContext* lastOwner = nullptr;
+
+		spinLock.Lock();
+		int32 i = 0;
+		for (; i < releaseCount; i++)
+		{
+			FiberContext* nextOwner = waiters.Pop();
+			if (nextOwner == nullptr)
+			{
+				break;
+			}
+
+			if (lastOwner != nullptr)
+			{
+				lastOwner->nextWaitingFiber = nextOwner;
+			} else
+			{
+				nextOwners = nextOwner;
+			}
+			lastOwner = nextOwner;
+		}
+		count += releaseCount - i;
+		TaskScheduler* scheduler = waiters.GetScheduler();
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Resume(scheduler, nextOwners);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	FiberConditionVariable::FiberConditionVariable()
+	{
+	}
+
+	void FiberConditionVariable::Wait(FiberContext& fiberContext, FiberMutex& mutex)
+	{
+		// Fiber is in the list before the mutex is released, so notification made under the mutex can't be missed
+		spinLock.Lock();
+		waiters.Push(fiberContext);
+		spinLock.Unlock();
+
+		mutex.Unlock();
+
+		internal::FiberWaitList::Suspend(fiberContext);
+
+		mutex.Lock(fiberContext);
+	}
+
+	void FiberConditionVariable::NotifyOne()
+	{
+		spinLock.Lock();
+		FiberContext* fiberContext = waiters.Pop();
+		TaskScheduler* scheduler = waiters.GetScheduler();
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Resume(scheduler, fiberContext);
+	}
+
+	void FiberConditionVariable::NotifyAll()
+	{
+		spinLock.Lock();
+		FiberContext* fiberContext = waiters.PopAll();
+		TaskScheduler* scheduler = waiters.GetScheduler();
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Resume(scheduler, fiberContext);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	FiberRWLock::FiberRWLock()
+		: readersCount(0)
+		, isWriterActive(false)
+	{
+	}
+
+	void FiberRWLock::LockShared(FiberContext& fiberContext)
+	{
+		spinLock.Lock();
+		if (isWriterActive == false && waitingWriters.IsEmpty())
+		{
+			readersCount++;
+			spinLock.Unlock();
+			return;
+		}
+
+		// Unlocking writer counts the reader in, fiber owns shared lock when resumed
+		waitingReaders.Push(fiberContext);
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Suspend(fiberContext);
+	}
+
+	void FiberRWLock::UnlockShared()
+	{
+		spinLock.Lock();
+		MT_ASSERT(readersCount > 0 && isWriterActive == false, "Shared lock is not locked");
+		readersCount--;
+
+		FiberContext* nextWriter = nullptr;
+		if (readersCount == 0)
+		{
+			nextWriter = waitingWriters.Pop();
+			isWriterActive = (nextWriter != nullptr);
+		}
+		TaskScheduler* scheduler = waitingWriters.GetScheduler();
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Resume(scheduler, nextWriter);
+	}
+
+	void FiberRWLock::Lock(FiberContext& fiberContext)
+	{
+		spinLock.Lock();
+		if (isWriterActive == false && readersCount == 0)
+		{
+			isWriterActive = true;
+			spinLock.Unlock();
+			return;
+		}
+
+		// Fiber owns exclusive lock when resumed
+		waitingWriters.Push(fiberContext);
+		spinLock.Unlock();
+
+		internal::FiberWaitList::Suspend(fiberContext);
+	}
+
+	void FiberRWLock::Unlock()
+	{
+		spinLock.Lock();
+		MT_ASSERT(isWriterActive && readersCount == 0, "Exclusive lock is not locked");
+
+		// Waiting readers go first, otherwise they would starve behind a stream of writers
+		FiberContext* nextOwners = waitingReaders.PopAll();
+		TaskScheduler* scheduler = waitingReaders.GetScheduler();
+		if (nextOwners != nullptr)
+		{
+			for (FiberContext* reader = nextOwners; reader != nullptr; reader = reader->nextWaitingFiber)
+			{
+				readersCount++;
+			}
+			isWriterActive = false;
+		} else
+		{
+			nextOwners = waitingWriters.Pop();
+			scheduler = waitingWriters.GetScheduler();
+			isWriterActive = (nextOwners != nullptr);
+		}
+		spinLock.Unlock();
+
+		// Either all readers or one writer, lock is not touched after the first of them is resumed
+		internal::FiberWaitList::Resume(scheduler, nextOwners);
+	}
+}
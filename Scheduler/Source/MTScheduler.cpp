@@ -32,57 +32,120 @@
 
 namespace MT
 {
+	// Context of the worker thread which is calling, null for non worker threads
+	static mt_thread_local internal::ThreadContext* currentWorkerContext = nullptr;
+
+	// Scheduler the calling external thread is waiting for in WaitGroup / WaitAll, such thread executes tasks as well
+	static mt_thread_local const TaskScheduler* currentWaitingScheduler = nullptr;
+
+#ifdef MT_INSTRUMENTED_BUILD
+	static SchedulerConfig MakeSchedulerConfig(uint32 workerThreadsCount, WorkerThreadParams* workerParameters, IProfilerEventListener* listener, TaskStealingMode::Type stealMode)
+#else
+	static SchedulerConfig MakeSchedulerConfig(uint32 workerThreadsCount, WorkerThreadParams* workerParameters, TaskStealingMode::Type stealMode)
+#endif
+	{
+		SchedulerConfig config;
+		config.workerThreadsCount = workerThreadsCount;
+		config.workerParameters = workerParameters;
+		config.stealMode = stealMode;
+#ifdef MT_INSTRUMENTED_BUILD
+		config.profilerEventListener = listener;
+#endif
+		return config;
+	}
+
 #ifdef MT_INSTRUMENTED_BUILD
 	TaskScheduler::TaskScheduler(uint32 workerThreadsCount, WorkerThreadParams* workerParameters, IProfilerEventListener* listener, TaskStealingMode::Type stealMode)
+		: TaskScheduler(MakeSchedulerConfig(workerThreadsCount, workerParameters, listener, stealMode))
 #else
 	TaskScheduler::TaskScheduler(uint32 workerThreadsCount, WorkerThreadParams* workerParameters, TaskStealingMode::Type stealMode)
+		: TaskScheduler(MakeSchedulerConfig(workerThreadsCount, workerParameters, stealMode))
 #endif
+	{
+	}
+
+	// Alignment of worker task queues bound to NUMA node, multiple of any regular page size
+	static const size_t NODE_MEMORY_ALIGNMENT = 65536;
+	static const size_t NODE_HUGE_MEMORY_ALIGNMENT = 2 * 1024 * 1024;
+
+	// Memory placement matters only if workers run on several NUMA nodes
+	static void BindToNode(void* p, size_t size, uint32 nodeId, uint32 nodesCount)
+	{
+		if (nodesCount > 1 && nodeId != MT_NUMA_NODE_ANY)
+		{
+			Memory::BindToNode(p, size, nodeId);
+		}
+	}
+
+	TaskScheduler::TaskScheduler(const SchedulerConfig& config)
 		: roundRobinThreadIndex(0)
 		, startedThreadsCount(0)
-		, taskStealingDisabled(stealMode == TaskStealingMode::DISABLED)
+		, parkedThreadsCount(0)
+		, overflowCount(0)
+		, deferredTasksCount(0)
+		, externalWaiters(nullptr)
+		, threadContext(nullptr)
+		, threadContextsCount(0)
+		, isHugePagesEnabled(config.useHugePages)
+		, numaNodesCount(0)
+		, parkedWorkersMask(nullptr)
+		, parkedWorkersMaskSize(0)
+		, availableGroups(TaskGroup::MT_MAX_GROUPS_COUNT * 2)
+		, taskQueueCapacity(config.taskQueueCapacity)
+		, fiberStackReleaseDelay(config.fiberStackReleaseDelay == MT_FIBER_STACK_RELEASE_DISABLED ? -1 : (int64)config.fiberStackReleaseDelay * 1000)
+		, taskStealingDisabled(config.stealMode == TaskStealingMode::DISABLED)
 	{
+		MT_ASSERT(IsPow2(config.taskQueueCapacity), "Task queue capacity must be power of 2");
+		MT_ASSERT(config.taskQueueCapacity > MT_TASK_STEAL_BATCH_MAX_COUNT, "Task queue capacity must be greater than steal batch size");
+		MT_ASSERT(config.fiberPools[StackRequirements::STANDARD].maxCount > 0, "At least one fiber with standard stack size is required");
 
 #ifdef MT_INSTRUMENTED_BUILD
-		profilerEventListener = listener;
+		profilerEventListener = config.profilerEventListener;
 #endif
 
-		if (workerThreadsCount != 0)
+		if (config.workerThreadsCount != 0)
 		{
-			threadsCount.StoreRelaxed( MT::Clamp(workerThreadsCount, (uint32)1, (uint32)MT_MAX_THREAD_COUNT) );
+			threadsCount.StoreRelaxed( config.workerThreadsCount );
 		} else
 		{
 			//query number of processor
-			threadsCount.StoreRelaxed( (uint32)MT::Clamp(Thread::GetNumberOfHardwareThreads() - 1, 1, (int)MT_MAX_THREAD_COUNT) );
+			threadsCount.StoreRelaxed( MT::Max(Thread::GetNumberOfHardwareThreads() - 1, 1) );
 		}
 
-		uint32 fiberIndex = 0;
+		// create worker thread contexts
+		threadContextsCount = (uint32)GetWorkersCount();
+		threadContext = (internal::ThreadContext*)Memory::Alloc(sizeof(internal::ThreadContext) * threadContextsCount, 64);
+		for (uint32 i = 0; i < threadContextsCount; i++)
+		{
+			new(&threadContext[i]) internal::ThreadContext();
+		}
 
-		// create fiber pool (fibers with standard stack size)
-		for (uint32 i = 0; i < MT_MAX_STANDART_FIBERS_COUNT; i++)
+		parkedWorkersMaskSize = (threadContextsCount + 31) / 32;
+		parkedWorkersMask = (Atomic32Base<uint32>*)Memory::Alloc(sizeof(Atomic32Base<uint32>) * parkedWorkersMaskSize, 64);
+		for (uint32 i = 0; i < parkedWorkersMaskSize; i++)
 		{
-			FiberContext& context = standartFiberContexts[i];
-			context.fiber.Create(MT_STANDART_FIBER_STACK_SIZE, FiberMain, &context);
-			context.fiberIndex = fiberIndex;
-			bool res = standartFibersAvailable.TryPush( &context );
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == true, "Can't add fiber to storage");
-			fiberIndex++;
+			parkedWorkersMask[i].StoreRelaxed(0);
 		}
 
-		// create fiber pool (fibers with extended stack size)
-		for (uint32 i = 0; i < MT_MAX_EXTENDED_FIBERS_COUNT; i++)
+		// Fiber pools and task queues are placed to NUMA nodes of the workers
+		CpuTopology topology;
+		const CpuTopology* workersTopology = topology.Query() ? &topology : nullptr;
+		InitNumaNodes(config.workerParameters, workersTopology);
+
+		// create fiber pools, one pool per stack class
+		uint32 totalFibersCount = 0;
+		for (uint32 i = 0; i < StackRequirements::COUNT; i++)
 		{
-			FiberContext& context = extendedFiberContexts[i];
-			context.fiber.Create(MT_EXTENDED_FIBER_STACK_SIZE, FiberMain, &context);
-			context.fiberIndex = fiberIndex;
-			bool res = extendedFibersAvailable.TryPush( &context );
-			MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res == true, "Can't add fiber to storage");
-			fiberIndex++;
+			const FiberPoolConfig& poolConfig = config.fiberPools[i];
+			MT_ASSERT(poolConfig.maxCount == 0 || StackRequirements::IsFiberStack((StackRequirements::Type)i), "Fibers pool is allowed for stack classes only");
+
+			fiberPools[i].Create(poolConfig.maxCount, poolConfig.initialCount, poolConfig.stackSize, totalFibersCount, isHugePagesEnabled, numaNodeIds, numaNodesCount);
+			totalFibersCount += poolConfig.maxCount;
 		}
 
 #ifdef MT_INSTRUMENTED_BUILD
-		NotifyFibersCreated(MT_MAX_STANDART_FIBERS_COUNT + MT_MAX_EXTENDED_FIBERS_COUNT);
+		// Fiber indices are reserved for all fibers, even if they are not created yet
+		NotifyFibersCreated(totalFibersCount);
 #endif
 
 		for (int16 i = 0; i < TaskGroup::MT_MAX_GROUPS_COUNT; i++)
@@ -99,6 +162,14 @@ namespace MT
 		groupStats[TaskGroup::DEFAULT].SetDebugIsFree(false);
 #endif
 
+#if MT_ENABLE_STACK_USAGE_TRACKING
+		for (uint32 i = 0; i < MT_STACK_USAGE_MAX_TASK_TYPES; i++)
+		{
+			taskStackUsage[i].debugID = nullptr;
+			taskStackUsage[i].stackRequirements = StackRequirements::INVALID;
+		}
+#endif
+
 		// create worker thread pool
 		int32 totalThreadsCount = GetWorkersCount();
 
@@ -106,260 +177,1308 @@ namespace MT
 		NotifyThreadsCreated(totalThreadsCount);
 #endif
 
+		InitVictimOrder(config.workerParameters, workersTopology);
+
+		// Queues of all workers share one memory block. With several NUMA nodes every queue takes whole pages bound to the worker node.
+		size_t taskQueueBytesCount = internal::ThreadContext::GetMemoryRequrementInBytesForTaskQueue(taskQueueCapacity);
+		if (numaNodesCount > 1)
+		{
+			taskQueueBytesCount = AlignUp(taskQueueBytesCount, config.useHugePages ? NODE_HUGE_MEMORY_ALIGNMENT : NODE_MEMORY_ALIGNMENT);
+		}
+
+		if (isHugePagesEnabled)
+		{
+			taskQueuesMemory = Memory::AllocHugePages(taskQueueBytesCount * totalThreadsCount);
+		} else if (numaNodesCount > 1)
+		{
+			taskQueuesMemory = Memory::AllocStack(taskQueueBytesCount * totalThreadsCount);
+		}
+
 		for (int32 i = 0; i < totalThreadsCount; i++)
 		{
 			threadContext[i].SetThreadIndex(i);
 			threadContext[i].taskScheduler = this;
 
+			void* taskQueueMemory = nullptr;
+			if (taskQueuesMemory.stackMemory != nullptr)
+			{
+				taskQueueMemory = (char*)taskQueuesMemory.stackBottom + taskQueueBytesCount * i;
+				BindToNode(taskQueueMemory, taskQueueBytesCount, numaNodeIds[threadContext[i].nodeIndex], numaNodesCount);
+			}
+			threadContext[i].CreateTaskQueue(taskQueueCapacity, taskQueueMemory);
+		}
+
+		for (int32 i = 0; i < totalThreadsCount; i++)
+		{
 			uint32 threadCore = i;
 			ThreadPriority::Type priority = ThreadPriority::DEFAULT;
-			if (workerParameters != nullptr)
+			if (config.workerParameters != nullptr)
 			{
-				const WorkerThreadParams& params = workerParameters[i];
+				const WorkerThreadParams& params = config.workerParameters[i];
 
 				threadCore = params.core;
 				priority = params.priority;
 			}
 
-			threadContext[i].thread.Start( MT_SCHEDULER_STACK_SIZE, WorkerThreadMain, &threadContext[i], threadCore, priority);
+			threadContext[i].thread.Start( config.schedulerStackSize, WorkerThreadMain, &threadContext[i], threadCore, priority);
 		}
 	}
 
-	void TaskScheduler::JoinWorkerThreads()
+	// Bounded MPMC queue operation can fail while other thread is preempted in the middle of push or pop.
+	// Empty pool is the usual reason of pop failure, so spin just a few times: a fiber missed this way
+	// is not lost, thread which returns it to the pool starts deferred tasks.
+	template<typename QUEUE>
+	static bool TryPopFiberContext(QUEUE& pool, FiberContext*& fiberContext)
 	{
-		int32 totalThreadsCount = GetWorkersCount();
-		for (int32 i = 0; i < totalThreadsCount; i++)
+		SpinWait spinWait;
+		while (!pool.TryPop(fiberContext))
 		{
-			threadContext[i].state.Store(internal::ThreadState::EXIT);
-			threadContext[i].hasNewTasksEvent.Signal();
+			if (spinWait.SpinOnce() >= SpinWait::YIELD_CPU_THRESHOLD)
+			{
+				return false;
+			}
 		}
+		return true;
+	}
 
-		for (int32 i = 0; i < totalThreadsCount; i++)
+	// Pool has room for all created fibers, so push can fail only due to the race above. Retry for a while before reporting error.
+	template<typename QUEUE>
+	static bool TryPushFiberContext(QUEUE& pool, FiberContext*&& fiberContext)
+	{
+		SpinWait spinWait;
+		while (!pool.TryPush(std::move(fiberContext)))
 		{
-			threadContext[i].thread.Join();
+			if (spinWait.SpinOnce() >= SpinWait::YIELD_SLEEP0_THRESHOLD)
+			{
+				return false;
+			}
 		}
-		threadsCount.Store(0);
+		return true;
 	}
 
-	TaskScheduler::~TaskScheduler()
+	// Keeps maximum of the stored and the new value
+	static void AtomicStoreMax(Atomic32<uint32>& value, uint32 newValue)
 	{
-		if (GetWorkersCount() > 0)
+		for(;;)
 		{
-			JoinWorkerThreads();
+			uint32 oldValue = value.Load();
+			if (newValue <= oldValue || value.CompareAndSwap(oldValue, newValue) == oldValue)
+			{
+				return;
+			}
 		}
 	}
 
-	FiberContext* TaskScheduler::RequestFiberContext(internal::GroupedTask& task)
+#if MT_ENABLE_STACK_USAGE_TRACKING
+	static const uint32 STACK_FILL_PATTERN = 0xCDCDCDCD;
+
+	// Top of the new fiber stack holds fiber entry frame, it is never filled
+	static const size_t STACK_TOP_RESERVED_BYTES = 1024;
+
+	// Distance from the current frame to the filled part of the stack, keeps callee frames and red zone intact
+	static const size_t STACK_FILL_SAFETY_BYTES = 512;
+
+	static void FillStack(uint32* begin, uint32* end)
 	{
-		FiberContext *fiberContext = task.awaitingFiber;
-		if (fiberContext)
+		for (uint32* p = begin; p < end; p++)
 		{
-			task.awaitingFiber = nullptr;
-			return fiberContext;
+			*p = STACK_FILL_PATTERN;
 		}
+	}
 
-		MT::StackRequirements::Type stackRequirements = task.desc.stackRequirements;
+	// Returns the lowest stack address written since the stack was filled (stack grows down)
+	static uint32* FindStackHighWaterMark(const Memory::StackDesc& stackDesc)
+	{
+		uint32* p = (uint32*)stackDesc.stackBottom;
+		uint32* top = (uint32*)stackDesc.stackTop;
+		while (p < top && *p == STACK_FILL_PATTERN)
+		{
+			p++;
+		}
+		return p;
+	}
+#endif
 
-		fiberContext = nullptr;
-		bool res = false;
-		MT_USED_IN_ASSERT(res);
-		switch(stackRequirements)
+	// Distance between fiber stacks placed in one memory block, multiple of any page size
+	static const size_t FIBER_STACK_ALIGNMENT = 16384;
+
+	// Fiber is parked in FiberMain while it is in the pool. Switch frames and saved registers lie below the recorded stack position.
+	static const size_t IDLE_FIBER_STACK_SAFETY_BYTES = 2048;
+
+	TaskScheduler::FiberPool::FiberPool()
+		: fiberContexts(nullptr)
+		, maxCount(0)
+		, stackSize(0)
+		, firstFiberIndex(0)
+		, nodeIds(nullptr)
+		, nodesCount(0)
+		, createdCount(0)
+		, inUseCount(0)
+		, peakInUseCount(0)
+	{
+	}
+
+	TaskScheduler::FiberPool::~FiberPool()
+	{
+		if (fiberContexts == nullptr)
 		{
-		case MT::StackRequirements::STANDARD:
-			res = standartFibersAvailable.TryPop(fiberContext);
-            MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res, "Can't get more standard fibers!");
-			break;
-		case MT::StackRequirements::EXTENDED:
-			res = extendedFibersAvailable.TryPop(fiberContext);
-            MT_USED_IN_ASSERT(res);
-			MT_ASSERT(res, "Can't get more extended fibers!");
-			break;
-		default:
-			MT_REPORT_ASSERT("Unknown stack requrements");
+			return;
 		}
 
-		MT_ASSERT(fiberContext != nullptr, "Can't get more fibers. Too many tasks in flight simultaneously?");
+		for (uint32 i = 0; i < maxCount; i++)
+		{
+			fiberContexts[i].~FiberContext();
+		}
+		Memory::Free(fiberContexts);
+		fiberContexts = nullptr;
 
-		fiberContext->currentTask = task.desc;
-		fiberContext->currentGroup = task.group;
-		fiberContext->parentFiber = task.parentFiber;
-		fiberContext->stackRequirements = stackRequirements;
-		return fiberContext;
+		if (stacksMemory.stackMemory != nullptr)
+		{
+			Memory::FreeHugePages(stacksMemory);
+			stacksMemory = Memory::StackDesc();
+		}
 	}
 
-	void TaskScheduler::ReleaseFiberContext(FiberContext*&& fiberContext)
+	void TaskScheduler::FiberPool::Create(uint32 maxFibersCount, uint32 initialFibersCount, uint32 fiberStackSize, uint32 firstIndex, bool useHugePages, const uint32* numaNodeIds, uint32 numaNodesCount)
 	{
-		MT_ASSERT(fiberContext, "Can't release nullptr Fiber. fiberContext is nullptr");
+		MT_ASSERT(fiberContexts == nullptr, "Fibers pool already created");
+		MT_ASSERT(numaNodesCount > 0 && numaNodesCount <= MT_MAX_NUMA_NODES_COUNT, "Invalid NUMA nodes count");
 
-		MT::StackRequirements::Type stackRequirements = fiberContext->stackRequirements;
-		fiberContext->Reset();
+		maxCount = maxFibersCount;
+		stackSize = fiberStackSize;
+		firstFiberIndex = firstIndex;
+		nodeIds = numaNodeIds;
+		nodesCount = numaNodesCount;
 
-		MT_ASSERT(fiberContext != nullptr, "Fiber context can't be nullptr");
+		// Pool capacity must be power of 2 and leave room for preempted push/pop operations. Any node can hold all fibers.
+		for (uint32 nodeIndex = 0; nodeIndex < nodesCount; nodeIndex++)
+		{
+			available[nodeIndex].Create( NextPow2(maxCount) * 2 );
+		}
 
-		bool res = false;
-		MT_USED_IN_ASSERT(res);
-		switch(stackRequirements)
+		if (maxCount == 0)
 		{
-		case MT::StackRequirements::STANDARD:
-			res = standartFibersAvailable.TryPush(std::move(fiberContext));
-			break;
-		case MT::StackRequirements::EXTENDED:
-			res = extendedFibersAvailable.TryPush(std::move(fiberContext));
-			break;
-		default:
-			MT_REPORT_ASSERT("Unknown stack requrements");
+			return;
 		}
 
-		MT_USED_IN_ASSERT(res);
-		MT_ASSERT(res != false, "Can't return fiber to storage");
+		// Address space for all stacks is reserved at once, physical pages are committed on first touch
+		if (useHugePages)
+		{
+			stacksMemory = Memory::AllocHugePages(AlignUp(stackSize, FIBER_STACK_ALIGNMENT) * maxCount);
+		}
+
+		// Fiber contexts are cheap, fibers are created later
+		fiberContexts = (FiberContext*)Memory::Alloc(sizeof(FiberContext) * maxCount, 64);
+		for (uint32 i = 0; i < maxCount; i++)
+		{
+			FiberContext* context = new(&fiberContexts[i]) FiberContext();
+			context->fiberIndex = firstFiberIndex + i;
+		}
+
+		// Initial fibers are split between nodes
+		uint32 nodeFibersCount = (MT::Min(initialFibersCount, maxCount) + nodesCount - 1) / nodesCount;
+		for (uint32 nodeIndex = 0; nodeIndex < nodesCount; nodeIndex++)
+		{
+			CreateFibers(nodeFibersCount, nodeIndex, nullptr);
+		}
 	}
 
-	FiberContext* TaskScheduler::ExecuteTask(internal::ThreadContext& threadContext, FiberContext* fiberContext)
+	uint32 TaskScheduler::FiberPool::CreateFibers(uint32 count, uint32 nodeIndex, FiberContext** firstCreated)
 	{
-		MT_ASSERT(threadContext.threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+		// Claim range of fiber contexts, other threads can grow the pool at the same time
+		uint32 firstIndex = 0;
+		uint32 lastIndex = 0;
+		for(;;)
+		{
+			firstIndex = createdCount.Load();
+			lastIndex = MT::Min(firstIndex + count, maxCount);
+			if (firstIndex == lastIndex || createdCount.CompareAndSwap(firstIndex, lastIndex) == firstIndex)
+			{
+				break;
+			}
+		}
 
-		MT_ASSERT(fiberContext, "Invalid fiber context");
-		MT_ASSERT(fiberContext->currentTask.IsValid(), "Invalid task");
+		for (uint32 i = firstIndex; i < lastIndex; i++)
+		{
+			FiberContext* context = &fiberContexts[i];
+			if (stacksMemory.stackMemory != nullptr)
+			{
+				size_t stackStride = AlignUp(stackSize, FIBER_STACK_ALIGNMENT);
 
-		// Set actual thread context to fiber
-		fiberContext->SetThreadContext(&threadContext);
+				Memory::StackDesc stackDesc;
+				stackDesc.stackBottom = (char*)stacksMemory.stackBottom + stackStride * i;
+				stackDesc.stackTop = (char*)stackDesc.stackBottom + stackStride;
+				context->fiber.Create(stackDesc, FiberMain, context);
+			} else
+			{
+				context->fiber.Create(stackSize, FiberMain, context);
+			}
 
-		// Update task status
-		fiberContext->SetStatus(FiberTaskStatus::RUNNED);
+			// Pages touched by fiber creation are moved to the node as well
+			context->nodeIndex = nodeIndex;
+			const Memory::StackDesc& stackDesc = context->fiber.GetStackDesc();
+			BindToNode(stackDesc.stackBottom, stackDesc.GetStackSize(), nodeIds[nodeIndex], nodesCount);
 
-		MT_ASSERT(fiberContext->GetThreadContext()->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+#if MT_ENABLE_STACK_USAGE_TRACKING
+			FillStack((uint32*)stackDesc.stackBottom, (uint32*)((char*)stackDesc.stackTop - STACK_TOP_RESERVED_BYTES));
+#endif
 
-		const void* poolUserData = fiberContext->currentTask.userData;
-		TPoolTaskDestroy poolDestroyFunc = fiberContext->currentTask.poolDestroyFunc;
+			if (firstCreated != nullptr && i == firstIndex)
+			{
+				*firstCreated = context;
+				continue;
+			}
 
-#ifdef MT_INSTRUMENTED_BUILD
-		threadContext.NotifyTaskExecuteStateChanged( MT_SYSTEM_TASK_COLOR, MT_SYSTEM_TASK_NAME, TaskExecuteState::STOP, MT_SYSTEM_FIBER_INDEX);
-#endif
+			bool res = TryPushFiberContext(available[nodeIndex], std::move(context));
+			MT_USED_IN_ASSERT(res);
+			MT_ASSERT(res == true, "Can't add fiber to storage");
+		}
 
-		// Run current task code
-		Fiber::SwitchTo(threadContext.schedulerFiber, fiberContext->fiber);
+		return lastIndex - firstIndex;
+	}
 
-#ifdef MT_INSTRUMENTED_BUILD
-		threadContext.NotifyTaskExecuteStateChanged( MT_SYSTEM_TASK_COLOR, MT_SYSTEM_TASK_NAME, TaskExecuteState::START, MT_SYSTEM_FIBER_INDEX);
-#endif
+	FiberContext* TaskScheduler::FiberPool::TryPop(uint32 nodeIndex)
+	{
+		MT_ASSERT(nodeIndex < nodesCount, "Invalid node index");
 
-		// If task was done
-		FiberTaskStatus::Type taskStatus = fiberContext->GetStatus();
-		if (taskStatus == FiberTaskStatus::FINISHED)
+		FiberContext* fiberContext = nullptr;
+		if (available[nodeIndex].TryPop(fiberContext) == false)
 		{
-			//destroy task (call dtor) for "fire and forget" type of task from TaskPool
-			if (poolDestroyFunc != nullptr)
+			// Slow path: stack creation is too expensive for the task which asks for a fiber,
+			// idle worker of the node creates the next fibers and starts deferred tasks.
+			if (createdCount.Load() < maxCount)
 			{
-				poolDestroyFunc(poolUserData);
+				isGrowRequested[nodeIndex].Store(1);
 			}
 
-			TaskGroup taskGroup = fiberContext->currentGroup;
-
-			TaskScheduler::TaskGroupDescription  & groupDesc = threadContext.taskScheduler->GetGroupDesc(taskGroup);
+			// Take free fiber of any node (local node first).
+			// Bounded queue still can fail while other thread is in the middle of push.
+			uint32 i = 0;
+			for (; i < nodesCount; i++)
+			{
+				if (TryPopFiberContext(available[(nodeIndex + i) % nodesCount], fiberContext))
+				{
+					break;
+				}
+			}
 
-			// Update group status
-			int groupTaskCount = groupDesc.Dec();
-			MT_ASSERT(groupTaskCount >= 0, "Sanity check failed!");
-			if (groupTaskCount == 0)
+			if (i == nodesCount)
 			{
-				fiberContext->currentGroup = TaskGroup::INVALID;
+				// No fiber is in use, so no fiber will be returned to start the deferred task. Create one right now.
+				if (inUseCount.Load() != 0 || CreateFibers(1, nodeIndex, &fiberContext) == 0)
+				{
+					return nullptr;
+				}
 			}
+		}
 
-			// Update total task count
-			int allGroupTaskCount = threadContext.taskScheduler->allGroups.Dec();
-			MT_USED_IN_ASSERT(allGroupTaskCount);
-			MT_ASSERT(allGroupTaskCount >= 0, "Sanity check failed!");
+		// Update peak usage
+		AtomicStoreMax(peakInUseCount, inUseCount.IncFetch());
 
-			FiberContext* parentFiberContext = fiberContext->parentFiber;
-			if (parentFiberContext != nullptr)
+		return fiberContext;
+	}
+
+	bool TaskScheduler::FiberPool::TryPush(FiberContext*&& fiberContext)
+	{
+		uint32 nodeIndex = fiberContext->nodeIndex;
+		MT_ASSERT(nodeIndex < nodesCount, "Invalid node index");
+
+		if (TryPushFiberContext(available[nodeIndex], std::move(fiberContext)) == false)
+		{
+			return false;
+		}
+
+		inUseCount.DecFetch();
+		return true;
+	}
+
+	uint32 TaskScheduler::FiberPool::GrowIfRequested(uint32 nodeIndex)
+	{
+		MT_ASSERT(nodeIndex < nodesCount, "Invalid node index");
+
+		Atomic32<uint32>& isNodeGrowRequested = isGrowRequested[nodeIndex];
+		if (isNodeGrowRequested.LoadRelaxed() == 0 || isNodeGrowRequested.CompareAndSwap(1, 0) != 1)
+		{
+			return 0;
+		}
+
+		// Double the node share of the pool
+		static const uint32 MIN_GROW_COUNT = 8;
+		return CreateFibers(MT::Max(createdCount.Load() / nodesCount, MIN_GROW_COUNT), nodeIndex, nullptr);
+	}
+
+	void TaskScheduler::FiberPool::ReleaseIdleStacks(int64 idleStartTimeLimit)
+	{
+		// Take idle fibers out of the pool one by one and put them back, so every idle fiber is visited once
+		uint32 idleCount = createdCount.Load() - MT::Min(inUseCount.Load(), createdCount.Load());
+		for (uint32 nodeIndex = 0; nodeIndex < nodesCount; nodeIndex++)
+		{
+			// Node queue is visited until its first fiber comes back
+			FiberContext* firstFiberContext = nullptr;
+			while (idleCount > 0)
 			{
-				int childrenFibersCount = parentFiberContext->childrenFibersCount.DecFetch();
-				MT_ASSERT(childrenFibersCount >= 0, "Sanity check failed!");
+				FiberContext* fiberContext = nullptr;
+				if (available[nodeIndex].TryPop(fiberContext) == false)
+				{
+					break;
+				}
 
-				if (childrenFibersCount == 0)
+				bool isVisited = (fiberContext == firstFiberContext);
+				if (firstFiberContext == nullptr)
 				{
-					// This is a last subtask. Restore parent task
-					MT_ASSERT(threadContext.threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
-					MT_ASSERT(parentFiberContext->GetThreadContext() == nullptr, "Inactive parent should not have a valid thread context");
+					firstFiberContext = fiberContext;
+				}
 
-					// WARNING!! Thread context can changed here! Set actual current thread context.
-					parentFiberContext->SetThreadContext(&threadContext);
+				if (fiberContext->hasResidentStack && fiberContext->idleStartTime <= idleStartTimeLimit)
+				{
+					const Memory::StackDesc& stackDesc = fiberContext->fiber.GetStackDesc();
+					size_t usedBytes = (char*)stackDesc.stackTop - (char*)fiberContext->idleStackPointer + IDLE_FIBER_STACK_SAFETY_BYTES;
+					Memory::ReleaseStackPages(stackDesc, usedBytes);
+					fiberContext->hasResidentStack = false;
+				}
 
-					MT_ASSERT(parentFiberContext->GetThreadContext()->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+				bool res = TryPushFiberContext(available[nodeIndex], std::move(fiberContext));
+				MT_USED_IN_ASSERT(res);
+				MT_ASSERT(res == true, "Can't return fiber to storage");
 
-					// All subtasks is done.
-					// Exiting and return parent fiber to scheduler
-					return parentFiberContext;
-				} else
+				if (isVisited)
 				{
-					// Other subtasks still exist
-					// Exiting
-					return nullptr;
+					break;
 				}
-			} else
-			{
-				// Task is finished and no parent task
-				// Exiting
-				return nullptr;
+				idleCount--;
 			}
 		}
+	}
 
-		MT_ASSERT(taskStatus != FiberTaskStatus::RUNNED, "Incorrect task status")
-		return nullptr;
+	TaskScheduler::FiberPool& TaskScheduler::GetFiberPool(StackRequirements::Type stackRequirements)
+	{
+		MT_ASSERT(StackRequirements::IsFiberStack(stackRequirements), "Unknown stack requrements");
+		return fiberPools[stackRequirements];
 	}
 
+	const TaskScheduler::FiberPool& TaskScheduler::GetFiberPool(StackRequirements::Type stackRequirements) const
+	{
+		MT_ASSERT(StackRequirements::IsFiberStack(stackRequirements), "Unknown stack requrements");
+		return fiberPools[stackRequirements];
+	}
 
-	void TaskScheduler::FiberMain(void* userData)
+	void TaskScheduler::GrowFiberPools(uint32 nodeIndex)
 	{
-		FiberContext& fiberContext = *(FiberContext*)(userData);
-		for(;;)
+		for (uint32 i = 0; i < StackRequirements::COUNT; i++)
 		{
-			MT_ASSERT(fiberContext.currentTask.IsValid(), "Invalid task in fiber context");
-			MT_ASSERT(fiberContext.GetThreadContext(), "Invalid thread context");
-			MT_ASSERT(fiberContext.GetThreadContext()->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+			// Tasks which asked for a fiber while the pool was empty are waiting for the new fibers
+			if (fiberPools[i].GrowIfRequested(nodeIndex) > 0 && StackRequirements::IsFiberStack((StackRequirements::Type)i))
+			{
+				RunDeferredTasks((StackRequirements::Type)i);
+			}
+		}
+	}
 
-#ifdef MT_INSTRUMENTED_BUILD
-			fiberContext.fiber.SetName( MT_SYSTEM_TASK_FIBER_NAME );
-			fiberContext.GetThreadContext()->NotifyTaskExecuteStateChanged( fiberContext.currentTask.debugColor, fiberContext.currentTask.debugID, TaskExecuteState::START, (int32)fiberContext.fiberIndex);
+	void TaskScheduler::ReleaseIdleFiberStacks(int64 idleStartTimeLimit)
+	{
+#if MT_ENABLE_STACK_USAGE_TRACKING
+		// Released pages lose the fill pattern, stack usage tracking needs resident stacks
+		MT_UNUSED(idleStartTimeLimit);
+#else
+		for (uint32 i = 0; i < StackRequirements::COUNT; i++)
+		{
+			fiberPools[i].ReleaseIdleStacks(idleStartTimeLimit);
+
+			// Fiber was taken out of the pool for a moment, new tasks could be deferred
+			HardwareFullMemoryBarrier();
+			if (StackRequirements::IsFiberStack((StackRequirements::Type)i))
+			{
+				RunDeferredTasks((StackRequirements::Type)i);
+			}
+		}
 #endif
+	}
 
-			fiberContext.currentTask.taskFunc( fiberContext, fiberContext.currentTask.userData );
-			fiberContext.SetStatus(FiberTaskStatus::FINISHED);
+	void TaskScheduler::ReleaseIdleFiberStacks()
+	{
+		ReleaseIdleFiberStacks(GetTimeMicroSeconds());
+	}
 
-#ifdef MT_INSTRUMENTED_BUILD
-			fiberContext.fiber.SetName( MT_SYSTEM_TASK_FIBER_NAME );
-			fiberContext.GetThreadContext()->NotifyTaskExecuteStateChanged( fiberContext.currentTask.debugColor, fiberContext.currentTask.debugID, TaskExecuteState::STOP, (int32)fiberContext.fiberIndex);
-#endif
+	void TaskScheduler::InitNumaNodes(const WorkerThreadParams* workerParameters, const CpuTopology* topology)
+	{
+		numaNodesCount = 0;
+
+		uint32 workersCount = (uint32)GetWorkersCount();
+		for (uint32 i = 0; i < workersCount; i++)
+		{
+			// Worker threads are pinned to core with the same index by default
+			uint32 core = (workerParameters != nullptr) ? workerParameters[i].core : i;
+			uint32 nodeId = (workerParameters != nullptr) ? workerParameters[i].numaNode : MT_NUMA_NODE_ANY;
+			if (nodeId == MT_NUMA_NODE_ANY && topology != nullptr && core != MT_CPUCORE_ANY)
+			{
+				nodeId = topology->GetNodeId(core);
+			}
+
+			uint32 nodeIndex = 0;
+			while (nodeIndex < numaNodesCount && numaNodeIds[nodeIndex] != nodeId)
+			{
+				nodeIndex++;
+			}
+
+			if (nodeIndex == numaNodesCount)
+			{
+				if (numaNodesCount < MT_MAX_NUMA_NODES_COUNT)
+				{
+					numaNodeIds[numaNodesCount] = nodeId;
+					numaNodesCount++;
+				} else
+				{
+					// Too many nodes, worker uses the first node pools
+					nodeIndex = 0;
+				}
+			}
+
+			threadContext[i].nodeIndex = nodeIndex;
+		}
+
+		if (numaNodesCount == 0)
+		{
+			numaNodeIds[0] = MT_NUMA_NODE_ANY;
+			numaNodesCount = 1;
+		}
+	}
+
+	uint32 TaskScheduler::GetCurrentNodeIndex() const
+	{
+		// External threads use fibers of the first node
+		internal::ThreadContext* context = currentWorkerContext;
+		if (context != nullptr && context->taskScheduler == this)
+		{
+			return context->nodeIndex;
+		}
+
+		return 0;
+	}
 
-			Fiber::SwitchTo(fiberContext.fiber, fiberContext.GetThreadContext()->schedulerFiber);
+	void TaskScheduler::InitVictimOrder(const WorkerThreadParams* workerParameters, const CpuTopology* topology)
+	{
+		uint32 workersCount = (uint32)GetWorkersCount();
+
+		// Worker threads are pinned to core with the same index by default
+		uint32* workerCores = (uint32*)MT_ALLOCATE_ON_STACK(sizeof(uint32) * workersCount);
+		for (uint32 i = 0; i < workersCount; i++)
+		{
+			workerCores[i] = (workerParameters != nullptr) ? workerParameters[i].core : i;
+		}
+
+		StealDistance::Type* distances = (StealDistance::Type*)MT_ALLOCATE_ON_STACK(sizeof(StealDistance::Type) * workersCount);
+
+		for (uint32 i = 0; i < workersCount; i++)
+		{
+			internal::ThreadContext& context = threadContext[i];
+
+			for (uint32 j = 0; j < workersCount; j++)
+			{
+				distances[j] = StealDistance::REMOTE;
+				if (topology != nullptr && workerCores[i] != MT_CPUCORE_ANY && workerCores[j] != MT_CPUCORE_ANY)
+				{
+					distances[j] = topology->GetDistance(workerCores[i], workerCores[j]);
+				}
+			}
+
+			const WorkerThreadParams* params = (workerParameters != nullptr) ? &workerParameters[i] : nullptr;
+			if (params != nullptr && params->victimOrder != nullptr)
+			{
+				// Application defined order
+				context.SetVictimsCount(params->victimOrderCount);
+				context.isVictimOrderRandomized = false;
+
+				for (uint32 k = 0; k < params->victimOrderCount; k++)
+				{
+					uint32 victimIndex = params->victimOrder[k];
+					MT_ASSERT(victimIndex < workersCount, "Invalid victim index");
+
+					context.victims[k] = victimIndex;
+					context.victimDistances[k] = (uint8)distances[victimIndex];
+				}
+				continue;
+			}
+
+			// Nearest victims first: SMT sibling, shared last level cache, same NUMA node, remote
+			context.SetVictimsCount(workersCount - 1);
+			context.isVictimOrderRandomized = true;
+
+			uint32 victimsCount = 0;
+			for (uint32 distance = 0; distance < StealDistance::COUNT; distance++)
+			{
+				for (uint32 j = 0; j < workersCount; j++)
+				{
+					if (j != i && distances[j] == (StealDistance::Type)distance)
+					{
+						context.victims[victimsCount] = j;
+						context.victimDistances[victimsCount] = (uint8)distance;
+						victimsCount++;
+					}
+				}
+			}
+			MT_ASSERT(victimsCount == context.victimsCount, "Sanity check failed");
+		}
+
+		// Reverse lists: spawner wakes the workers which can steal from it, not its own victims.
+		// Orders are equal for topology order, but application defined order can be any.
+		for (uint32 i = 0; i < workersCount; i++)
+		{
+			internal::ThreadContext& context = threadContext[i];
+
+			uint32 thievesCount = 0;
+			for (uint32 j = 0; j < workersCount; j++)
+			{
+				if (j != i && GetStealDistance(threadContext[j], i) < StealDistance::COUNT)
+				{
+					thievesCount++;
+				}
+			}
+
+			context.SetThievesCount(thievesCount);
+
+			uint32 index = 0;
+			for (uint32 distance = 0; distance < StealDistance::COUNT; distance++)
+			{
+				for (uint32 j = 0; j < workersCount; j++)
+				{
+					if (j != i && GetStealDistance(threadContext[j], i) == distance)
+					{
+						context.thieves[index] = j;
+						index++;
+					}
+				}
+			}
+			MT_ASSERT(index == thievesCount, "Sanity check failed");
+		}
+	}
+
+	uint32 TaskScheduler::GetStealDistance(const internal::ThreadContext& thiefContext, uint32 victimIndex)
+	{
+		// Worker without steal order visits all workers
+		if (thiefContext.victimsCount == 0)
+		{
+			return StealDistance::REMOTE;
+		}
+
+		for (uint32 k = 0; k < thiefContext.victimsCount; k++)
+		{
+			if (thiefContext.victims[k] == victimIndex)
+			{
+				return thiefContext.victimDistances[k];
+			}
+		}
+
+		// Worker never steals from the victim
+		return StealDistance::COUNT;
+	}
+
+	void TaskScheduler::JoinWorkerThreads()
+	{
+		int32 totalThreadsCount = GetWorkersCount();
+		for (int32 i = 0; i < totalThreadsCount; i++)
+		{
+			threadContext[i].state.Store(internal::ThreadState::EXIT);
+			threadContext[i].hasNewTasksEvent.Signal();
+		}
+
+		for (int32 i = 0; i < totalThreadsCount; i++)
+		{
+			threadContext[i].thread.Join();
+		}
+		threadsCount.Store(0);
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		if (GetWorkersCount() > 0)
+		{
+			JoinWorkerThreads();
+		}
+
+		for (uint32 i = 0; i < threadContextsCount; i++)
+		{
+			threadContext[i].~ThreadContext();
+		}
+		Memory::Free(threadContext);
+		threadContext = nullptr;
+		threadContextsCount = 0;
+
+		if (taskQueuesMemory.stackMemory != nullptr)
+		{
+			if (isHugePagesEnabled)
+			{
+				Memory::FreeHugePages(taskQueuesMemory);
+			} else
+			{
+				Memory::FreeStack(taskQueuesMemory);
+			}
+			taskQueuesMemory = Memory::StackDesc();
+		}
+
+		Memory::Free(parkedWorkersMask);
+		parkedWorkersMask = nullptr;
+		parkedWorkersMaskSize = 0;
+
+	}
+
+	static void AttachTaskToFiberContext(FiberContext* fiberContext, const internal::GroupedTask& task)
+	{
+		fiberContext->currentTask = task.desc;
+		fiberContext->currentGroup = task.group;
+		fiberContext->currentCounter = task.counter;
+		fiberContext->parentFiber = task.parentFiber;
+		fiberContext->stackRequirements = task.desc.stackRequirements;
+	}
+
+	FiberContext* TaskScheduler::RequestFiberContext(internal::GroupedTask& task, uint32 nodeIndex)
+	{
+		FiberContext *fiberContext = task.awaitingFiber;
+		if (fiberContext)
+		{
+			task.awaitingFiber = nullptr;
+			return fiberContext;
+		}
+
+		MT::StackRequirements::Type stackRequirements = task.desc.stackRequirements;
+
+		fiberContext = GetFiberPool(stackRequirements).TryPop(nodeIndex);
+		if (fiberContext == nullptr)
+		{
+			// All fibers are in use, caller should defer the task
+			return nullptr;
+		}
+
+		AttachTaskToFiberContext(fiberContext, task);
+		return fiberContext;
+	}
+
+	void TaskScheduler::ReleaseFiberContext(FiberContext*&& fiberContext)
+	{
+		MT_ASSERT(fiberContext, "Can't release nullptr Fiber. fiberContext is nullptr");
+
+		MT::StackRequirements::Type stackRequirements = fiberContext->stackRequirements;
+		fiberContext->Reset();
+
+		if (stackRequirements == StackRequirements::STACKLESS)
+		{
+			// Thread's own stackless context, nothing to return to the pool
+			return;
+		}
+
+		fiberContext->hasResidentStack = true;
+		if (fiberStackReleaseDelay >= 0)
+		{
+			fiberContext->idleStartTime = GetTimeMicroSeconds();
+		}
+
+		bool res = GetFiberPool(stackRequirements).TryPush(std::move(fiberContext));
+		MT_USED_IN_ASSERT(res);
+		MT_ASSERT(res != false, "Can't return fiber to storage");
+
+		// Returned fiber must be visible before deferred tasks are checked, pairs with the full barrier in DeferTask
+		HardwareFullMemoryBarrier();
+		RunDeferredTasks(stackRequirements);
+	}
+
+	void TaskScheduler::ResumeAwaitingFiber(FiberContext* fiberContext)
+	{
+		// Task with attached fiber is scheduled the same way as yielded one, counters already include it
+		internal::GroupedTask task(fiberContext->currentTask, fiberContext->currentGroup);
+		task.awaitingFiber = fiberContext;
+
+		internal::TaskBucket bucket(&task, 1);
+		ArrayView<internal::TaskBucket> buckets(&bucket, 1);
+		RunTasksImpl(buckets, nullptr, true, nullptr, nullptr);
+	}
+
+	void TaskScheduler::AddGroupWaiter(TaskGroup group, FiberContext* fiberContext)
+	{
+		TaskGroupDescription& groupDesc = GetGroupDesc(group);
+		groupDesc.PushWaitingFiber(fiberContext);
+
+		// The last task could be finished before the fiber was added to the list, nobody else would wake it up then.
+		// Full barriers of the list push and of the group counter decrement guarantee that at least one side sees the other.
+		if (groupDesc.GetTaskCount() == 0)
+		{
+			WakeUpGroupWaiters(groupDesc, false);
+		}
+	}
+
+	FiberContext* TaskScheduler::WakeUpGroupWaiters(TaskGroupDescription& groupDesc, bool canResumeOnCallerThread)
+	{
+		FiberContext* resumedFiber = nullptr;
+
+		FiberContext* fiberContext = groupDesc.PopWaitingFibers();
+		while (fiberContext != nullptr)
+		{
+			// Woken fiber can wait for a group again right after it is resumed
+			FiberContext* nextFiberContext = fiberContext->nextWaitingFiber;
+			fiberContext->nextWaitingFiber = nullptr;
+
+			// Fiber which is still being suspended keeps the scheduler token and is resumed by its own worker
+			if (fiberContext->childrenFibersCount.DecFetch() == 0)
+			{
+				if (canResumeOnCallerThread && resumedFiber == nullptr)
+				{
+					resumedFiber = fiberContext;
+				} else
+				{
+					ResumeAwaitingFiber(fiberContext);
+				}
+			}
+
+			fiberContext = nextFiberContext;
+		}
+
+		return resumedFiber;
+	}
+
+	void TaskScheduler::AddCounterWaiter(TaskCounter& counter, FiberContext* fiberContext)
+	{
+		// Other waiter resumed from here can destroy the counter, destructor waits for active updates
+		counter.activeUpdatesCount.IncFetch();
+		counter.PushWaitingFiber(fiberContext);
+
+		// Target could be reached before the fiber was added to the list
+		if (counter.GetValue() <= fiberContext->waitTargetValue)
+		{
+			WakeUpCounterWaiters(counter, false);
+		}
+
+		counter.activeUpdatesCount.DecFetch();
+	}
+
+	FiberContext* TaskScheduler::DecrementCounter(TaskCounter& counter, bool canResumeOnCallerThread)
+	{
+		// Counter owner can destroy the counter as soon as its value is reached, destructor waits for active updates
+		counter.activeUpdatesCount.IncFetch();
+		counter.value.DecFetch();
+
+		FiberContext* resumedFiber = WakeUpCounterWaiters(counter, canResumeOnCallerThread);
+
+		counter.activeUpdatesCount.DecFetch();
+		return resumedFiber;
+	}
+
+	FiberContext* TaskScheduler::WakeUpCounterWaiters(TaskCounter& counter, bool canResumeOnCallerThread)
+	{
+		FiberContext* resumedFiber = nullptr;
+
+		for(;;)
+		{
+			FiberContext* fiberContext = counter.PopWaitingFibers();
+			if (fiberContext == nullptr)
+			{
+				return resumedFiber;
+			}
+
+			// Fibers have different targets, not ready fibers are returned to the list
+			int32 value = counter.GetValue();
+			bool isAnyReturned = false;
+			int32 maxReturnedTargetValue = 0;
+
+			while (fiberContext != nullptr)
+			{
+				FiberContext* nextFiberContext = fiberContext->nextWaitingFiber;
+
+				if (value > fiberContext->waitTargetValue)
+				{
+					counter.PushWaitingFiber(fiberContext);
+					maxReturnedTargetValue = isAnyReturned ? MT::Max(maxReturnedTargetValue, fiberContext->waitTargetValue) : fiberContext->waitTargetValue;
+					isAnyReturned = true;
+				} else
+				{
+					fiberContext->nextWaitingFiber = nullptr;
+					if (fiberContext->childrenFibersCount.DecFetch() == 0)
+					{
+						if (canResumeOnCallerThread && resumedFiber == nullptr)
+						{
+							resumedFiber = fiberContext;
+						} else
+						{
+							ResumeAwaitingFiber(fiberContext);
+						}
+					}
+				}
+
+				fiberContext = nextFiberContext;
+			}
+
+			// Returned fibers were out of the list for a moment, the thread which reached their target could miss them
+			if (isAnyReturned == false || counter.GetValue() > maxReturnedTargetValue)
+			{
+				return resumedFiber;
+			}
+		}
+	}
+
+	void TaskScheduler::DeferTask(internal::GroupedTask& task)
+	{
+		MT_ASSERT(task.awaitingFiber == nullptr, "Only new tasks can be deferred");
+
+		FiberPool& fiberPool = GetFiberPool(task.desc.stackRequirements);
+		fiberPool.deferredTasks.Push(&task, 1);
+		deferredTasksCount.IncFetch();
+
+		// Fiber could be returned before the task became visible to the releasing thread, so check again
+		HardwareFullMemoryBarrier();
+		RunDeferredTasks(task.desc.stackRequirements);
+	}
+
+	void TaskScheduler::RunDeferredTasks(StackRequirements::Type stackRequirements)
+	{
+		FiberPool& fiberPool = GetFiberPool(stackRequirements);
+		while (fiberPool.deferredTasks.IsEmpty() == false)
+		{
+			FiberContext* fiberContext = fiberPool.TryPop(GetCurrentNodeIndex());
+			if (fiberContext == nullptr)
+			{
+				// Fibers are still in use, the deferred tasks will be started by the next ReleaseFiberContext
+				return;
+			}
+
+			internal::GroupedTask task;
+			if (fiberPool.deferredTasks.TryPop(&task, 1) == 0)
+			{
+				// Other thread took the last deferred task (or holds the queue right now)
+				bool res = fiberPool.TryPush(std::move(fiberContext));
+				MT_USED_IN_ASSERT(res);
+				MT_ASSERT(res != false, "Can't return fiber to storage");
+				return;
+			}
+
+			AttachTaskToFiberContext(fiberContext, task);
+
+			// Task with attached fiber is scheduled the same way as resumed one, counters already include it
+			task.awaitingFiber = fiberContext;
+
+			internal::TaskBucket bucket(&task, 1);
+			ArrayView<internal::TaskBucket> buckets(&bucket, 1);
+			RunTasksImpl(buckets, nullptr, true, nullptr, nullptr);
+		}
+	}
+
+	void TaskScheduler::RunDeferredTasks()
+	{
+		for (uint32 i = 0; i < StackRequirements::COUNT; i++)
+		{
+			if (StackRequirements::IsFiberStack((StackRequirements::Type)i))
+			{
+				RunDeferredTasks((StackRequirements::Type)i);
+			}
+		}
+	}
+
+	FiberContext* TaskScheduler::ExecuteTask(internal::ThreadContext& threadContext, FiberContext* fiberContext)
+	{
+		MT_ASSERT(threadContext.threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+
+		MT_ASSERT(fiberContext, "Invalid fiber context");
+		MT_ASSERT(fiberContext->currentTask.IsValid(), "Invalid task");
+
+		// Set actual thread context to fiber
+		fiberContext->SetThreadContext(&threadContext);
+
+		// Update task status
+		fiberContext->SetStatus(FiberTaskStatus::RUNNED);
+
+		MT_ASSERT(fiberContext->GetThreadContext()->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+
+#ifdef MT_INSTRUMENTED_BUILD
+		threadContext.NotifyTaskExecuteStateChanged( MT_SYSTEM_TASK_COLOR, MT_SYSTEM_TASK_NAME, TaskExecuteState::STOP, MT_SYSTEM_FIBER_INDEX);
+#endif
+
+		if (fiberContext->stackRequirements == StackRequirements::STACKLESS)
+		{
+			// Task never suspends, run it right here on the scheduler fiber
+#ifdef MT_INSTRUMENTED_BUILD
+			threadContext.NotifyTaskExecuteStateChanged( fiberContext->currentTask.debugColor, fiberContext->currentTask.debugID, TaskExecuteState::START, MT_SYSTEM_FIBER_INDEX);
+#endif
+			fiberContext->currentTask.taskFunc( *fiberContext, fiberContext->currentTask.userData );
+
+#ifdef MT_INSTRUMENTED_BUILD
+			threadContext.NotifyTaskExecuteStateChanged( fiberContext->currentTask.debugColor, fiberContext->currentTask.debugID, TaskExecuteState::STOP, MT_SYSTEM_FIBER_INDEX);
+#endif
+			fiberContext->readyParentFiber = FinishTask(threadContext, fiberContext);
+			fiberContext->SetStatus(FiberTaskStatus::FINISHED);
+		} else
+		{
+			// Run current task code
+			Fiber::SwitchTo(threadContext.schedulerFiber, fiberContext->fiber);
+		}
+
+#ifdef MT_INSTRUMENTED_BUILD
+		threadContext.NotifyTaskExecuteStateChanged( MT_SYSTEM_TASK_COLOR, MT_SYSTEM_TASK_NAME, TaskExecuteState::START, MT_SYSTEM_FIBER_INDEX);
+#endif
+
+		// If task was done
+		FiberTaskStatus::Type taskStatus = fiberContext->GetStatus();
+		if (taskStatus == FiberTaskStatus::FINISHED)
+		{
+			// Task is already finished by the fiber. Return parent fiber if this was its last subtask
+			FiberContext* parentFiberContext = fiberContext->readyParentFiber;
+			fiberContext->readyParentFiber = nullptr;
+
+			if (parentFiberContext != nullptr)
+			{
+				MT_ASSERT(parentFiberContext->GetThreadContext() == nullptr, "Inactive parent should not have a valid thread context");
+
+				// WARNING!! Thread context can changed here! Set actual current thread context.
+				parentFiberContext->SetThreadContext(&threadContext);
+
+				MT_ASSERT(parentFiberContext->GetThreadContext()->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+			}
+			return parentFiberContext;
+		}
+
+		MT_ASSERT(taskStatus != FiberTaskStatus::RUNNED, "Incorrect task status")
+		return nullptr;
+	}
+
+	FiberContext* TaskScheduler::FinishTask(internal::ThreadContext& threadContext, FiberContext* fiberContext)
+	{
+		MT_ASSERT(threadContext.threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+
+		//destroy task (call dtor) for "fire and forget" type of task from TaskPool
+		TPoolTaskDestroy poolDestroyFunc = fiberContext->currentTask.poolDestroyFunc;
+		if (poolDestroyFunc != nullptr)
+		{
+			poolDestroyFunc(fiberContext->currentTask.userData);
+		}
+
+		TaskGroup taskGroup = fiberContext->currentGroup;
+
+		TaskScheduler::TaskGroupDescription  & groupDesc = threadContext.taskScheduler->GetGroupDesc(taskGroup);
+
+		// Update group status
+		FiberContext* readyWaitingFiber = nullptr;
+		int groupTaskCount = groupDesc.Dec();
+		MT_ASSERT(groupTaskCount >= 0, "Sanity check failed!");
+		if (groupTaskCount == 0)
+		{
+			fiberContext->currentGroup = TaskGroup::INVALID;
+
+			// The first fiber waiting for the group can be resumed by this thread
+			readyWaitingFiber = threadContext.taskScheduler->WakeUpGroupWaiters(groupDesc, true);
+			threadContext.taskScheduler->WakeUpExternalWaiters(groupDesc);
+		}
+
+		// Update task counter, the fiber waiting for it can be resumed by this thread as well
+		TaskCounter* counter = fiberContext->currentCounter;
+		if (counter != nullptr)
+		{
+			fiberContext->currentCounter = nullptr;
+
+			FiberContext* readyCounterWaiter = threadContext.taskScheduler->DecrementCounter(*counter, readyWaitingFiber == nullptr);
+			if (readyCounterWaiter != nullptr)
+			{
+				readyWaitingFiber = readyCounterWaiter;
+			}
+		}
+
+		// Update total task count
+		int allGroupTaskCount = threadContext.taskScheduler->allGroups.Dec();
+		MT_ASSERT(allGroupTaskCount >= 0, "Sanity check failed!");
+		if (allGroupTaskCount == 0)
+		{
+			threadContext.taskScheduler->WakeUpExternalWaiters(threadContext.taskScheduler->allGroups);
+		}
+
+		FiberContext* parentFiberContext = fiberContext->parentFiber;
+		if (parentFiberContext == nullptr)
+		{
+			// Task is finished and no parent task
+			return readyWaitingFiber;
+		}
+
+		int childrenFibersCount = parentFiberContext->childrenFibersCount.DecFetch();
+		MT_ASSERT(childrenFibersCount >= 0, "Sanity check failed!");
+
+		if (childrenFibersCount == 0)
+		{
+			// This is a last subtask. Parent task must be restored by this thread, waiting fiber goes to the queue
+			if (readyWaitingFiber != nullptr)
+			{
+				threadContext.taskScheduler->ResumeAwaitingFiber(readyWaitingFiber);
+			}
+			return parentFiberContext;
+		}
+
+		// Other subtasks still exist
+		return readyWaitingFiber;
+	}
+
+	bool TaskScheduler::TryPopTaskForFiber(internal::ThreadContext& threadContext, FiberContext& fiberContext)
+	{
+		if (threadContext.queue.IsCreated() == false || threadContext.state.Load() == internal::ThreadState::EXIT)
+		{
+			return false;
+		}
+
+		// Tasks waiting in the overflow or injection queues and fibers waiting for deferred tasks are taken by the scheduler fiber,
+		// don't keep them waiting behind the local queue
+		TaskScheduler* taskScheduler = threadContext.taskScheduler;
+		if (threadContext.overflowQueue.IsEmpty() == false || taskScheduler->GetFiberPool(fiberContext.stackRequirements).deferredTasks.IsEmpty() == false)
+		{
+			return false;
+		}
+
+		for (uint32 priority = 0; priority < TaskPriority::COUNT; priority++)
+		{
+			if (taskScheduler->injectionQueues[priority].IsEmpty() == false)
+			{
+				return false;
+			}
+		}
+
+		internal::GroupedTask task;
+		if (threadContext.queue.TryPopLocal(task) == false)
+		{
+			return false;
+		}
+
+		if (task.awaitingFiber != nullptr || task.desc.stackRequirements != fiberContext.stackRequirements)
+		{
+			// Task can't run on this fiber, put it back where the scheduler fiber and thieves can find it.
+			// Queue has just lost this task, but the task could come from the inbox while the deque is full.
+			if (threadContext.queue.AddLocal(&task, 1) == 0)
+			{
+				threadContext.overflowQueue.Push(&task, 1);
+			}
+			return false;
+		}
+
+		AttachTaskToFiberContext(&fiberContext, task);
+		return true;
+	}
+
+#if MT_ENABLE_STACK_USAGE_TRACKING
+	void TaskScheduler::TrackStackUsage(FiberContext& fiberContext)
+	{
+		const Memory::StackDesc& stackDesc = fiberContext.fiber.GetStackDesc();
+		uint32* highWaterMark = FindStackHighWaterMark(stackDesc);
+
+		uint32 usedBytes = (uint32)((char*)stackDesc.stackTop - (char*)highWaterMark);
+		fiberContext.GetThreadContext()->taskScheduler->UpdateStackUsage(fiberContext.currentTask, usedBytes);
+
+		// Restore the pattern for the next task. This code is running on the same stack, so fill stops below the current frame
+		uint32 stackMarker = 0;
+		FillStack(highWaterMark, (uint32*)((char*)&stackMarker - STACK_FILL_SAFETY_BYTES));
+	}
+
+	void TaskScheduler::UpdateStackUsage(const internal::TaskDesc& task, uint32 usedBytes)
+	{
+		AtomicStoreMax(peakStackUsage[task.stackRequirements], usedBytes);
+
+		void* taskFunc = (void*)task.taskFunc;
+		uint32 firstIndex = (uint32)(((uintptr_t)taskFunc >> 4) % MT_STACK_USAGE_MAX_TASK_TYPES);
+		for (uint32 i = 0; i < MT_STACK_USAGE_MAX_TASK_TYPES; i++)
+		{
+			TaskStackUsageSlot& slot = taskStackUsage[(firstIndex + i) % MT_STACK_USAGE_MAX_TASK_TYPES];
+
+			void* slotTaskFunc = slot.taskFunc.Load();
+			if (slotTaskFunc == nullptr)
+			{
+				// Claim free slot
+				slotTaskFunc = slot.taskFunc.CompareAndSwap(nullptr, taskFunc);
+				if (slotTaskFunc == nullptr)
+				{
+#ifdef MT_INSTRUMENTED_BUILD
+					slot.debugID = task.debugID;
+#endif
+					slot.stackRequirements = task.stackRequirements;
+					slotTaskFunc = taskFunc;
+				}
+			}
+
+			if (slotTaskFunc == taskFunc)
+			{
+				AtomicStoreMax(slot.peakBytes, usedBytes);
+				return;
+			}
+		}
+
+		// Table is full, task type is counted in stack class peak only
+	}
+#endif
+
+	void TaskScheduler::FiberMain(void* userData)
+	{
+		FiberContext& fiberContext = *(FiberContext*)(userData);
+		uint32 reusedCount = 0;
+		for(;;)
+		{
+			MT_ASSERT(fiberContext.currentTask.IsValid(), "Invalid task in fiber context");
+			MT_ASSERT(fiberContext.GetThreadContext(), "Invalid thread context");
+			MT_ASSERT(fiberContext.GetThreadContext()->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+
+#ifdef MT_INSTRUMENTED_BUILD
+			fiberContext.fiber.SetName( MT_SYSTEM_TASK_FIBER_NAME );
+			fiberContext.GetThreadContext()->NotifyTaskExecuteStateChanged( fiberContext.currentTask.debugColor, fiberContext.currentTask.debugID, TaskExecuteState::START, (int32)fiberContext.fiberIndex);
+#endif
+
+			fiberContext.currentTask.taskFunc( fiberContext, fiberContext.currentTask.userData );
+
+#if MT_ENABLE_STACK_USAGE_TRACKING
+			TrackStackUsage(fiberContext);
+#endif
+
+#ifdef MT_INSTRUMENTED_BUILD
+			fiberContext.fiber.SetName( MT_SYSTEM_TASK_FIBER_NAME );
+			fiberContext.GetThreadContext()->NotifyTaskExecuteStateChanged( fiberContext.currentTask.debugColor, fiberContext.currentTask.debugID, TaskExecuteState::STOP, (int32)fiberContext.fiberIndex);
+#endif
+
+			internal::ThreadContext& threadContext = *fiberContext.GetThreadContext();
+			FiberContext* readyParentFiber = FinishTask(threadContext, &fiberContext);
+
+			// Run the next new task from the thread queue on the same fiber, without switching to scheduler fiber and back.
+			// Number of tasks in a row is limited, scheduler fiber must get control to grow fiber pools and check for other work.
+			if (readyParentFiber == nullptr && reusedCount < MT_FIBER_REUSE_MAX_COUNT && TryPopTaskForFiber(threadContext, fiberContext))
+			{
+				reusedCount++;
+				continue;
+			}
+
+			fiberContext.readyParentFiber = readyParentFiber;
+			fiberContext.idleStackPointer = &readyParentFiber;
+			fiberContext.SetStatus(FiberTaskStatus::FINISHED);
+
+			Fiber::SwitchTo(fiberContext.fiber, threadContext.schedulerFiber);
+			reusedCount = 0;
+		}
+
+	}
+
+
+	// Maximum number of tasks which can be taken from other queue by the thread in one go
+	static size_t GetMaxTakenTasksCount(internal::ThreadContext& threadContext)
+	{
+		// Thread without own queue (external thread waiting for tasks) can take only one task
+		return threadContext.queue.IsCreated() ? MT_TASK_STEAL_BATCH_MAX_COUNT : 1;
+	}
+
+	// Execute the oldest task right now and move the rest to the thread's own queue
+	static bool AcceptTakenTasks(internal::ThreadContext& threadContext, internal::GroupedTask & task, internal::GroupedTask* takenTasks, size_t takenCount)
+	{
+		if (takenCount == 0)
+		{
+			return false;
+		}
+
+		task = takenTasks[0];
+		if (takenCount > 1)
+		{
+			size_t addedCount = threadContext.queue.AddLocal(takenTasks + 1, takenCount - 1);
+			MT_USED_IN_ASSERT(addedCount);
+			MT_ASSERT(addedCount == (takenCount - 1), "Can't add taken tasks to the thread queue");
+		}
+		return true;
+	}
+
+	static bool StealTasksFromVictim(internal::ThreadContext& threadContext, internal::ThreadContext& victimContext, internal::GroupedTask & task, internal::GroupedTask* stolenTasks, size_t maxStolenCount)
+	{
+		size_t stolenCount = victimContext.queue.TryStealBatch(stolenTasks, maxStolenCount);
+		if (stolenCount == 0)
+		{
+			// Victim's queue is empty, but tasks which did not fit into the queue can wait in the overflow queue
+			stolenCount = victimContext.overflowQueue.TryPop(stolenTasks, maxStolenCount);
+		}
+
+		return AcceptTakenTasks(threadContext, task, stolenTasks, stolenCount);
+	}
+
+	static bool TryPopOverflowTask(internal::ThreadContext& threadContext, internal::GroupedTask & task)
+	{
+		if (threadContext.overflowQueue.IsEmpty())
+		{
+			return false;
+		}
+
+		internal::GroupedTask takenTasks[MT_TASK_STEAL_BATCH_MAX_COUNT];
+		size_t takenCount = threadContext.overflowQueue.TryPop(takenTasks, GetMaxTakenTasksCount(threadContext));
+		return AcceptTakenTasks(threadContext, task, takenTasks, takenCount);
+	}
+
+	bool TaskScheduler::TryPopInjectedTask(internal::ThreadContext& threadContext, internal::GroupedTask & task)
+	{
+		TaskScheduler* taskScheduler = threadContext.taskScheduler;
+		for (uint32 priority = 0; priority < TaskPriority::COUNT; priority++)
+		{
+			BatchQueueMPSC<internal::GroupedTask>& injectionQueue = taskScheduler->injectionQueues[priority];
+			if (injectionQueue.IsEmpty())
+			{
+				continue;
+			}
+
+			internal::GroupedTask takenTasks[MT_TASK_STEAL_BATCH_MAX_COUNT];
+			size_t takenCount = injectionQueue.TryPop(takenTasks, GetMaxTakenTasksCount(threadContext));
+			if (AcceptTakenTasks(threadContext, task, takenTasks, takenCount))
+			{
+				return true;
+			}
 		}
-
+		return false;
 	}
 
-
 	bool TaskScheduler::TryStealTask(internal::ThreadContext& threadContext, internal::GroupedTask & task)
 	{
-		uint32 workersCount = threadContext.taskScheduler->GetWorkersCount();
+		TaskScheduler* taskScheduler = threadContext.taskScheduler;
+
+		static_assert(MT_TASK_STEAL_BATCH_MAX_COUNT >= 1, "Invalid steal batch size");
+		internal::GroupedTask stolenTasks[MT_TASK_STEAL_BATCH_MAX_COUNT];
 
-		uint32 victimIndex = threadContext.random.Get();
+		size_t maxStolenCount = GetMaxTakenTasksCount(threadContext);
 
-		for (uint32 attempt = 0; attempt < workersCount; attempt++)
+		if (threadContext.victims == nullptr)
 		{
-			uint32 index = victimIndex % workersCount;
-			if (index == threadContext.workerIndex)
+			// No steal order (external thread or single worker), visit all workers starting from random one
+			uint32 workersCount = taskScheduler->GetWorkersCount();
+			uint32 victimIndex = threadContext.random.Get();
+
+			for (uint32 attempt = 0; attempt < workersCount; attempt++)
 			{
+				internal::ThreadContext& victimContext = taskScheduler->threadContext[victimIndex % workersCount];
+				if (&victimContext != &threadContext && StealTasksFromVictim(threadContext, victimContext, task, stolenTasks, maxStolenCount))
+				{
+					return true;
+				}
+
 				victimIndex++;
-				index = victimIndex % workersCount;
 			}
+			return false;
+		}
+
+		// Visit nearest victims first, victims with equal distance are visited starting from random one
+		uint32 groupBegin = 0;
+		while (groupBegin < threadContext.victimsCount)
+		{
+			uint8 distance = threadContext.victimDistances[groupBegin];
 
-			internal::ThreadContext& victimContext = threadContext.taskScheduler->threadContext[index];
-			if (victimContext.queue.TryPopNewest(task))
+			uint32 groupEnd = groupBegin + 1;
+			if (threadContext.isVictimOrderRandomized)
 			{
-				return true;
+				while (groupEnd < threadContext.victimsCount && threadContext.victimDistances[groupEnd] == distance)
+				{
+					groupEnd++;
+				}
+			}
+
+			uint32 groupSize = groupEnd - groupBegin;
+			uint32 offset = (groupSize > 1) ? (threadContext.random.Get() % groupSize) : 0;
+
+			for (uint32 i = 0; i < groupSize; i++)
+			{
+				uint32 index = threadContext.victims[groupBegin + ((offset + i) % groupSize)];
+				if (StealTasksFromVictim(threadContext, taskScheduler->threadContext[index], task, stolenTasks, maxStolenCount))
+				{
+					// Only owner thread writes to histogram
+					Atomic32<uint32>& stealCount = threadContext.stealDistanceHistogram[distance];
+					stealCount.StoreRelaxed(stealCount.LoadRelaxed() + 1);
+					return true;
+				}
 			}
 
-			victimIndex++;
+			groupBegin = groupEnd;
 		}
 		return false;
 	}
@@ -370,6 +1489,7 @@ namespace MT
 		MT_ASSERT(context.taskScheduler, "Task scheduler must be not null!");
 
 		context.threadId = ThreadId::Self();
+		currentWorkerContext = &context;
 
 #ifdef MT_INSTRUMENTED_BUILD
 		const char* threadNames[] = {"worker0","worker1","worker2","worker3","worker4","worker5","worker6","worker7","worker8","worker9","worker10","worker11","worker12"};
@@ -410,7 +1530,20 @@ namespace MT
 		{
 			if ( SchedulerFiberStep(context, isTaskStealingDisabled) == false )
 			{
-				spinWait.SpinOnce();
+				if (spinWait.SpinOnce() >= SpinWait::YIELD_THREAD_THRESHOLD)
+				{
+					// Tasks deferred by this thread wait for fibers of the first node, workers of the node can be parked
+					context.taskScheduler->GrowFiberPools(context.nodeIndex);
+
+					// Nothing to help with, sleep until the thread which finishes the last task signals the event.
+					// Waiter was registered before the first counter check, so the signal can't be missed.
+					int64 timeLeft = timeOut - GetTimeMicroSeconds();
+					if (timeLeft > 0)
+					{
+						waitContext.externalWaiter->wakeUpEvent.Wait((uint32)((timeLeft + 999) / 1000));
+					}
+					spinWait.Reset();
+				}
 			} else
 			{
 				spinWait.Reset();
@@ -480,53 +1613,64 @@ namespace MT
 				context.NotifyThreadIdleStarted(context.workerIndex);
 #endif
 
-#if MT_LOW_LATENCY_EXPERIMENTAL_WAIT
+				internal::GroupedTask task;
+				bool hasTask = false;
 
+#if MT_LOW_LATENCY_EXPERIMENTAL_WAIT
+				// Queue is empty and stealing attempt has failed.
+				// Fast Spin Wait for new tasks
 				SpinWait spinWait;
+				while (hasTask == false && spinWait.SpinOnce() < SpinWait::YIELD_SLEEP0_THRESHOLD)
+				{
+					hasTask = TryGetTask(context, isTaskStealingDisabled, task);
+				}
+#endif
 
-				for(;;)
+				if (hasTask == false)
 				{
-					// Queue is empty and stealing attempt has failed.
-					// Fast Spin Wait for new tasks
-					if (spinWait.SpinOnce() >= SpinWait::YIELD_SLEEP0_THRESHOLD)
-					{
-						// Fast Spin wait for new tasks has failed.
-						// Wait for new events using events
-						context.hasNewTasksEvent.Wait(20000);
+					// Nothing to do, good time to create fibers requested by tasks
+					context.taskScheduler->GrowFiberPools(context.nodeIndex);
+					context.taskScheduler->RunDeferredTasks();
 
-						spinWait.Reset();
+					int64 fiberStackReleaseDelay = context.taskScheduler->fiberStackReleaseDelay;
+					if (fiberStackReleaseDelay >= 0)
+					{
+						context.taskScheduler->ReleaseIdleFiberStacks(GetTimeMicroSeconds() - fiberStackReleaseDelay);
+					}
 
-#ifdef MT_INSTRUMENTED_BUILD
-						context.NotifyThreadIdleFinished(context.workerIndex);
-#endif
+					// Publish parked state, submitters signal only parked workers
+					context.isParked.Store(1);
+					context.taskScheduler->SetParkedWorkerBit(context.workerIndex, true);
+					context.taskScheduler->parkedThreadsCount.IncFetch();
 
-						break;
+					// Tasks could be queued before the parked state became visible to submitter, so check again
+					HardwareFullMemoryBarrier();
+					hasTask = TryGetTask(context, isTaskStealingDisabled, task);
+					if (hasTask == false)
+					{
+						// Queue is empty and stealing attempt has failed.
+						// Wait for new events using events
+						context.hasNewTasksEvent.Wait(20000);
 					}
 
-					internal::GroupedTask task;
-					if ( context.queue.TryPopOldest(task) )
+					// Leave parked state, if submitter has not done it already
+					if (context.isParked.CompareAndSwap(1, 0) == 1)
 					{
-#ifdef MT_INSTRUMENTED_BUILD
-						context.NotifyThreadIdleFinished(context.workerIndex);
-#endif
-
-						SchedulerFiberProcessTask(context, task);
-
-						break;
+						context.taskScheduler->parkedThreadsCount.DecFetch();
 					}
 
+					// Only the worker itself changes its bit, so the bit can't be lost while the worker is parked
+					context.taskScheduler->SetParkedWorkerBit(context.workerIndex, false);
 				}
-#else
-				// Queue is empty and stealing attempt has failed.
-				// Wait for new events using events
-				context.hasNewTasksEvent.Wait(20000);
 
 #ifdef MT_INSTRUMENTED_BUILD
 				context.NotifyThreadIdleFinished(context.workerIndex);
 #endif
 
-#endif
-
+				if (hasTask)
+				{
+					SchedulerFiberProcessTask(context, task);
+				}
 			}
 
 		} // main thread loop
@@ -545,8 +1689,26 @@ namespace MT
 #endif
 
 		// There is a new task
-		FiberContext* fiberContext = context.taskScheduler->RequestFiberContext(task);
-		MT_ASSERT(fiberContext, "Can't get execution context from pool");
+		FiberContext* fiberContext = nullptr;
+		if (task.desc.stackRequirements == StackRequirements::STACKLESS)
+		{
+			// Stackless task is executed on the scheduler fiber and finished before the next task is taken
+			MT_ASSERT(task.awaitingFiber == nullptr, "Stackless task can't be resumed");
+			MT_ASSERT(context.stacklessFiberContext.currentTask.IsValid() == false, "Stackless context is already in use");
+
+			fiberContext = &context.stacklessFiberContext;
+			AttachTaskToFiberContext(fiberContext, task);
+		} else
+		{
+			fiberContext = context.taskScheduler->RequestFiberContext(task, context.nodeIndex);
+			if (fiberContext == nullptr)
+			{
+				// All fibers are in use. Task will be started when one of the running tasks returns its fiber
+				context.taskScheduler->DeferTask(task);
+				return;
+			}
+		}
+
 		MT_ASSERT(fiberContext->currentTask.IsValid(), "Sanity check failed");
 		MT_ASSERT(fiberContext->stackRequirements == task.desc.stackRequirements, "Sanity check failed");
 
@@ -603,7 +1765,7 @@ namespace MT
 					internal::DistibuteDescriptions( TaskGroup(TaskGroup::ASSIGN_FROM_CONTEXT), yieldedTasksQueue.Begin(), buffer, buckets );
 
 					// add yielded task to scheduler
-					context.taskScheduler->RunTasksImpl(buckets, nullptr, true);
+					context.taskScheduler->RunTasksImpl(buckets, nullptr, true, nullptr, nullptr);
 
 					// ATENTION! yielded task can be already completed at this point
 
@@ -613,10 +1775,15 @@ namespace MT
 		} //while(fiberContext)
 	}
 
+	bool TaskScheduler::TryGetTask( internal::ThreadContext& context, bool disableTaskStealing, internal::GroupedTask& task)
+	{
+		return context.queue.TryPopLocal(task) || TryPopOverflowTask(context, task) || TryPopInjectedTask(context, task) || (disableTaskStealing == false && TryStealTask(context, task) );
+	}
+
 	bool TaskScheduler::SchedulerFiberStep( internal::ThreadContext& context, bool disableTaskStealing)
 	{
 		internal::GroupedTask task;
-		if ( context.queue.TryPopOldest(task) || (disableTaskStealing == false && TryStealTask(context, task) ) )
+		if ( TryGetTask(context, disableTaskStealing, task) )
 		{
 			SchedulerFiberProcessTask(context, task);
 			return true;
@@ -625,21 +1792,9 @@ namespace MT
 		return false;
 	}
 
-	void TaskScheduler::RunTasksImpl(ArrayView<internal::TaskBucket>& buckets, FiberContext * parentFiber, bool restoredFromAwaitState)
+	void TaskScheduler::RunTasksImpl(ArrayView<internal::TaskBucket>& buckets, FiberContext * parentFiber, bool restoredFromAwaitState, internal::ThreadContext* spawnerContext, TaskCounter* counter)
 	{
 
-#if MT_LOW_LATENCY_EXPERIMENTAL_WAIT
-		// Early wakeup worker threads (worker thread spin wait for some time before sleep)
-		int32 roundRobinIndex = roundRobinThreadIndex.LoadRelaxed();
-		for (size_t i = 0; i < buckets.Size(); ++i)
-		{
-			int bucketIndex = ((roundRobinIndex + i) % threadsCount.LoadRelaxed());
-			internal::ThreadContext & context = threadContext[bucketIndex];
-			context.hasNewTasksEvent.Signal();
-		}
-#endif
-
-
 		// This storage is necessary to calculate how many tasks we add to different groups
 		int newTaskCountInGroup[TaskGroup::MT_MAX_GROUPS_COUNT];
 
@@ -658,6 +1813,10 @@ namespace MT
 				internal::GroupedTask & task = bucket.tasks[taskIndex];
 
 				task.parentFiber = parentFiber;
+				if (restoredFromAwaitState == false)
+				{
+					task.counter = counter;
+				}
 
 				int idx = task.group.GetValidIndex();
 				MT_ASSERT(idx >= 0 && idx < TaskGroup::MT_MAX_GROUPS_COUNT, "Invalid index");
@@ -687,39 +1846,203 @@ namespace MT
 
 			// Increments all task in progress counter
 			allGroups.Add((uint32)count);
+
+			if (counter != nullptr)
+			{
+				counter->value.AddFetch((int32)count);
+			}
 		} else
 		{
 			// If task's restored from await state, counters already in correct state
 		}
 
+		size_t bucketIndexToDistribute = 0;
+
+		// Workers which should be woken up after tasks are queued
+		uint32 wakeUpCount = 0;
+		internal::ThreadContext* wakeUpNearestTo = nullptr;
+		uint32* targetWorkers = (uint32*)MT_ALLOCATE_ON_STACK(sizeof(uint32) * buckets.Size());
+
+#if !MT_ENABLE_ROUND_ROBIN_SUBMISSION
+		// Work-first: tasks spawned by worker thread go to its own queue, other workers take them by stealing.
+		// Keeps child data hot in the parent's cache and avoids contention on the shared round robin index.
+		if (spawnerContext != nullptr && restoredFromAwaitState == false && spawnerContext->queue.IsCreated() && IsTaskStealingDisabled() == false)
+		{
+			MT_ASSERT(spawnerContext->threadId.IsEqual(ThreadId::Self()), "Thread context sanity check failed");
+
+			for (; bucketIndexToDistribute < buckets.Size(); ++bucketIndexToDistribute)
+			{
+				internal::TaskBucket& bucket = buckets[bucketIndexToDistribute];
+				if (spawnerContext->queue.AddLocal(bucket.tasks, bucket.count) != bucket.count)
+				{
+					// Own queue is full, distribute the remaining tasks between all workers
+					break;
+				}
+			}
+
+			// Spawner executes one bucket itself, the nearest workers steal the rest
+			wakeUpCount = (bucketIndexToDistribute > 1) ? (uint32)bucketIndexToDistribute - 1 : 0;
+			wakeUpNearestTo = spawnerContext;
+		}
+
+		// Tasks from external threads go to the global injection queues, submitter never touches worker queues.
+		// Idle workers drain injection queues in batches.
+		if (spawnerContext == nullptr && restoredFromAwaitState == false && IsTaskStealingDisabled() == false)
+		{
+			for (size_t i = 0; i < buckets.Size(); ++i)
+			{
+				internal::TaskBucket& bucket = buckets[i];
+
+				// Split bucket to the runs of tasks with the same priority (usually whole bucket has the same priority)
+				size_t runStartIndex = 0;
+				for (size_t taskIndex = 1; taskIndex <= bucket.count; taskIndex++)
+				{
+					TaskPriority::Type priority = bucket.tasks[runStartIndex].desc.priority;
+					if (taskIndex == bucket.count || bucket.tasks[taskIndex].desc.priority != priority)
+					{
+						MT_ASSERT((uint32)priority < TaskPriority::COUNT, "Invalid task priority");
+						injectionQueues[priority].Push(bucket.tasks + runStartIndex, taskIndex - runStartIndex);
+						runStartIndex = taskIndex;
+					}
+				}
+			}
+
+			// Wake up one worker per bucket
+			wakeUpCount = (uint32)buckets.Size();
+			bucketIndexToDistribute = buckets.Size();
+		}
+#else
+		MT_UNUSED(spawnerContext);
+#endif
+
 		// Add to thread queue
-		for (size_t i = 0; i < buckets.Size(); ++i)
+		for (size_t i = bucketIndexToDistribute; i < buckets.Size(); ++i)
 		{
 			int bucketIndex = roundRobinThreadIndex.IncFetch() % threadsCount.LoadRelaxed();
 			internal::ThreadContext & context = threadContext[bucketIndex];
+			targetWorkers[i] = (uint32)bucketIndex;
 
 			internal::TaskBucket& bucket = buckets[i];
 
-			for(;;)
+			// Owner thread can add new tasks directly to the work stealing queue.
+			// Restored tasks always go through the inbox, otherwise yielded task will be popped again immediately.
+			bool isOwnerThread = (restoredFromAwaitState == false) && context.threadId.IsEqual(ThreadId::Self());
+
+			MT_ASSERT(bucket.count < (taskQueueCapacity - 1), "Sanity check failed. Too many tasks per one bucket.");
+
+			size_t addedCount = 0;
+			if (isOwnerThread)
+			{
+				addedCount = context.queue.AddLocal(bucket.tasks, bucket.count);
+			} else
+			{
+				addedCount = context.queue.Add(bucket.tasks, bucket.count);
+			}
+
+			if (addedCount < bucket.count)
+			{
+				// Can't add new tasks onto the queue. Looks like the job system is overloaded.
+				// Put the rest of the tasks into the unbounded overflow queue, so submitter never waits.
+				context.overflowQueue.Push(bucket.tasks + addedCount, bucket.count - addedCount);
+				overflowCount.IncFetch();
+			}
+		}
+
+		// Queued tasks must be visible before parked state is read, pairs with the full barrier in the parking worker.
+		HardwareFullMemoryBarrier();
+
+		// Busy workers are not signaled at all
+		if (parkedThreadsCount.Load() <= 0)
+		{
+			return;
+		}
+
+		WakeUpParkedWorkers(wakeUpCount, nullptr, wakeUpNearestTo);
+
+		for (size_t i = bucketIndexToDistribute; i < buckets.Size(); ++i)
+		{
+			WakeUpParkedWorkers(1, &threadContext[targetWorkers[i]], nullptr);
+		}
+	}
+
+	bool TaskScheduler::TryWakeUpParkedWorker(internal::ThreadContext& context)
+	{
+		// Only one thread can take the worker out of the parked state
+		if (context.isParked.LoadRelaxed() == 0 || context.isParked.CompareAndSwap(1, 0) != 1)
+		{
+			return false;
+		}
+
+		parkedThreadsCount.DecFetch();
+		context.hasNewTasksEvent.Signal();
+		return true;
+	}
+
+	bool TaskScheduler::IsParkedWorker(uint32 workerIndex) const
+	{
+		// Bit can be set for a moment after the worker was woken up, TryWakeUpParkedWorker makes the final decision
+		uint32 mask = parkedWorkersMask[workerIndex / 32].LoadRelaxed();
+		return (mask & (1u << (workerIndex % 32))) != 0;
+	}
+
+	void TaskScheduler::SetParkedWorkerBit(uint32 workerIndex, bool isParked)
+	{
+		Atomic32Base<uint32>& word = parkedWorkersMask[workerIndex / 32];
+		uint32 bit = 1u << (workerIndex % 32);
+		for(;;)
+		{
+			uint32 oldMask = word.Load();
+			uint32 newMask = isParked ? (oldMask | bit) : (oldMask & ~bit);
+			if (oldMask == newMask || word.CompareAndSwap(oldMask, newMask) == oldMask)
+			{
+				return;
+			}
+		}
+	}
+
+	void TaskScheduler::WakeUpParkedWorkers(uint32 count, internal::ThreadContext* preferredContext, internal::ThreadContext* nearestToContext)
+	{
+		uint32 wokenCount = 0;
+		if (preferredContext != nullptr && TryWakeUpParkedWorker(*preferredContext))
+		{
+			wokenCount++;
+		}
+
+		// Other workers can get the tasks only by stealing
+		if (wokenCount >= count || IsTaskStealingDisabled())
+		{
+			return;
+		}
+
+		if (nearestToContext != nullptr)
+		{
+			// Only the workers which have the spawner in their victim order can take its tasks
+			for (uint32 i = 0; i < nearestToContext->thievesCount && wokenCount < count && parkedThreadsCount.Load() > 0; i++)
 			{
-				MT_ASSERT(bucket.count < (internal::TASK_BUFFER_CAPACITY - 1), "Sanity check failed. Too many tasks per one bucket.");
-				
-				bool res = context.queue.Add(bucket.tasks, bucket.count);
-				if (res == true)
+				uint32 thiefIndex = nearestToContext->thieves[i];
+				if (IsParkedWorker(thiefIndex) && TryWakeUpParkedWorker(threadContext[thiefIndex]))
 				{
-					break;
+					wokenCount++;
 				}
+			}
+			return;
+		}
 
-				//Can't add new tasks onto the queue. Look like the job system is overloaded. Wait some time and try again.
-				//TODO: implement waiting until workers done using events.
-				Thread::Sleep(10);
+		// Scan the parked workers mask, 32 workers per word
+		for (uint32 wordIndex = 0; wordIndex < parkedWorkersMaskSize && wokenCount < count && parkedThreadsCount.Load() > 0; wordIndex++)
+		{
+			uint32 mask = parkedWorkersMask[wordIndex].LoadRelaxed();
+			for (uint32 bitIndex = 0; mask != 0 && wokenCount < count; bitIndex++, mask >>= 1)
+			{
+				if ((mask & 1) != 0 && TryWakeUpParkedWorker(threadContext[wordIndex * 32 + bitIndex]))
+				{
+					wokenCount++;
+				}
 			}
-			
-			context.hasNewTasksEvent.Signal();
 		}
 	}
 
-	void TaskScheduler::RunAsync(TaskGroup group, const TaskHandle* taskHandleArray, uint32 taskHandleCount)
+	void TaskScheduler::RunAsync(TaskGroup group, const TaskHandle* taskHandleArray, uint32 taskHandleCount, TaskCounter* counter)
 	{
 		MT_ASSERT(!IsWorkerThread(), "Can't use RunAsync inside Task. Use FiberContext.RunAsync() instead.");
 
@@ -729,7 +2052,7 @@ namespace MT
 		ArrayView<internal::TaskBucket> buckets(MT_ALLOCATE_ON_STACK(sizeof(internal::TaskBucket) * bucketCount), bucketCount);
 
 		internal::DistibuteDescriptions(group, taskHandleArray, buffer, buckets);
-		RunTasksImpl(buckets, nullptr, false);
+		RunTasksImpl(buckets, nullptr, false, nullptr, counter);
 	}
 
 	bool TaskScheduler::WaitGroup(TaskGroup group, uint32 milliseconds)
@@ -745,28 +2068,7 @@ namespace MT
 			return true;
 		}
 
-		size_t bytesCountForDescBuffer = internal::ThreadContext::GetMemoryRequrementInBytesForDescBuffer();
-		void* descBuffer = MT_ALLOCATE_ON_STACK(bytesCountForDescBuffer);
-		
-		internal::ThreadContext context(descBuffer);
-		context.taskScheduler = this;
-		context.SetThreadIndex(0xFFFFFFFF);
-		context.threadId = ThreadId::Self();
-
-		WaitContext waitContext;
-		waitContext.threadContext = &context;
-		waitContext.waitCounter = groupDesc.GetWaitCounter();
-		waitContext.waitTimeMs = milliseconds;
-		waitContext.exitCode = 0;
-
-		int32 waitingSlotIndex = nextWaitingThreadSlotIndex.IncFetch();
-		waitingThreads[waitingSlotIndex % waitingThreads.size()] = ThreadId::Self();
-		context.schedulerFiber.CreateFromCurrentThreadAndRun(SchedulerFiberWait, &waitContext);
-		
-		MT_ASSERT( waitingThreads[waitingSlotIndex % waitingThreads.size()].IsEqual(ThreadId::Self()), "waitingThreads array overflow");
-		waitingThreads[waitingSlotIndex % waitingThreads.size()] = ThreadId();
-
-		return (waitContext.exitCode == 0);
+		return WaitExternal(groupDesc, milliseconds);
 	}
 
 	bool TaskScheduler::WaitAll(uint32 milliseconds)
@@ -780,31 +2082,110 @@ namespace MT
 			return true;
 		}
 
-		size_t bytesCountForDescBuffer = internal::ThreadContext::GetMemoryRequrementInBytesForDescBuffer();
-		void* descBuffer = MT_ALLOCATE_ON_STACK(bytesCountForDescBuffer);
+		return WaitExternal(allGroups, milliseconds);
+	}
+
+	bool TaskScheduler::WaitExternal(TaskGroupDescription& groupDesc, uint32 milliseconds)
+	{
+		// Buffer size depends on the task queue capacity set at run time, it can be too large for the caller's stack
+		size_t bytesCountForDescBuffer = internal::ThreadContext::GetMemoryRequrementInBytesForDescBuffer(taskQueueCapacity);
+		void* descBuffer = Memory::Alloc(bytesCountForDescBuffer);
 
 		internal::ThreadContext context(descBuffer);
 		context.taskScheduler = this;
 		context.SetThreadIndex(0xFFFFFFFF);
 		context.threadId = ThreadId::Self();
 
+		ExternalWaiter waiter(groupDesc.GetWaitCounter());
+		AddExternalWaiter(groupDesc, waiter);
+
 		WaitContext waitContext;
 		waitContext.threadContext = &context;
-		waitContext.waitCounter = allGroups.GetWaitCounter();
+		waitContext.waitCounter = groupDesc.GetWaitCounter();
+		waitContext.externalWaiter = &waiter;
 		waitContext.waitTimeMs = milliseconds;
 		waitContext.exitCode = 0;
 
-		int32 waitingSlotIndex = nextWaitingThreadSlotIndex.IncFetch();
-		waitingThreads[waitingSlotIndex % waitingThreads.size()] = ThreadId::Self();
+		// Waiting thread can wait for another scheduler only, IsWorkerThread() prevents nested waits
+		const TaskScheduler* prevWaitingScheduler = currentWaitingScheduler;
+		currentWaitingScheduler = this;
 
 		context.schedulerFiber.CreateFromCurrentThreadAndRun(SchedulerFiberWait, &waitContext);
 
-		MT_ASSERT( waitingThreads[waitingSlotIndex % waitingThreads.size()].IsEqual(ThreadId::Self()), "waitingThreads array overflow");
-		waitingThreads[waitingSlotIndex % waitingThreads.size()] = ThreadId();
+		MT_ASSERT(currentWaitingScheduler == this, "Sanity check failed!");
+		currentWaitingScheduler = prevWaitingScheduler;
+
+		RemoveExternalWaiter(groupDesc, waiter);
+
+		Memory::Free(descBuffer);
 
 		return (waitContext.exitCode == 0);
 	}
 
+	void TaskScheduler::AddExternalWaiter(TaskGroupDescription& groupDesc, ExternalWaiter& waiter)
+	{
+		{
+			MT::ScopedGuard guard(externalWaitersLock);
+
+			waiter.prev = nullptr;
+			waiter.next = externalWaiters;
+			if (externalWaiters != nullptr)
+			{
+				externalWaiters->prev = &waiter;
+			}
+			externalWaiters = &waiter;
+		}
+
+		// Waiter is in the list before the count is published. Full barrier, pairs with the counter decrement in FinishTask:
+		// either finisher sees the waiter or waiter sees zero counter.
+		groupDesc.GetExternalWaitersCount().IncFetch();
+	}
+
+	void TaskScheduler::RemoveExternalWaiter(TaskGroupDescription& groupDesc, ExternalWaiter& waiter)
+	{
+		groupDesc.GetExternalWaitersCount().DecFetch();
+
+		// Event is signaled under the lock, so waiter can be destroyed once it is out of the list
+		MT::ScopedGuard guard(externalWaitersLock);
+
+		if (waiter.prev != nullptr)
+		{
+			waiter.prev->next = waiter.next;
+		} else
+		{
+			MT_ASSERT(externalWaiters == &waiter, "Sanity check failed!");
+			externalWaiters = waiter.next;
+		}
+
+		if (waiter.next != nullptr)
+		{
+			waiter.next->prev = waiter.prev;
+		}
+
+		waiter.prev = nullptr;
+		waiter.next = nullptr;
+	}
+
+	void TaskScheduler::WakeUpExternalWaiters(TaskGroupDescription& groupDesc)
+	{
+		// Fast path, nobody waits for the group from outside
+		if (groupDesc.GetExternalWaitersCount().Load() == 0)
+		{
+			return;
+		}
+
+		Atomic32<int32>* waitCounter = groupDesc.GetWaitCounter();
+
+		MT::ScopedGuard guard(externalWaitersLock);
+		for (ExternalWaiter* waiter = externalWaiters; waiter != nullptr; waiter = waiter->next)
+		{
+			if (waiter->waitCounter == waitCounter)
+			{
+				waiter->wakeUpEvent.Signal();
+			}
+		}
+	}
+
 	bool TaskScheduler::IsTaskStealingDisabled(uint32 minWorkersCount) const
 	{
 		if (threadsCount.LoadRelaxed() <= (int32)minWorkersCount)
@@ -821,23 +2202,99 @@ namespace MT
 	}
 
 
-	bool TaskScheduler::IsWorkerThread() const
+	void TaskScheduler::GetStealDistanceHistogram(uint32 histogram[StealDistance::COUNT]) const
 	{
-		int32 threadsCount = GetWorkersCount();
-		for (int32 i = 0; i < threadsCount; i++)
+		for (uint32 distance = 0; distance < StealDistance::COUNT; distance++)
+		{
+			histogram[distance] = 0;
+		}
+
+		int32 workersCount = GetWorkersCount();
+		for (int32 i = 0; i < workersCount; i++)
 		{
-			if (threadContext[i].threadId.IsEqual(ThreadId::Self()))
+			for (uint32 distance = 0; distance < StealDistance::COUNT; distance++)
 			{
-				return true;
+				histogram[distance] += threadContext[i].stealDistanceHistogram[distance].Load();
+			}
+		}
+	}
+
+	uint32 TaskScheduler::GetQueueOverflowCount() const
+	{
+		return overflowCount.Load();
+	}
+
+	uint32 TaskScheduler::GetDeferredTasksCount() const
+	{
+		return deferredTasksCount.Load();
+	}
+
+#if MT_ENABLE_STACK_USAGE_TRACKING
+	uint32 TaskScheduler::GetPeakStackUsage(StackRequirements::Type stackRequirements) const
+	{
+		MT_ASSERT(StackRequirements::IsFiberStack(stackRequirements), "Unknown stack requrements");
+		return peakStackUsage[stackRequirements].Load();
+	}
+
+	uint32 TaskScheduler::GetTaskStackUsage(TaskStackUsage* items, uint32 maxCount) const
+	{
+		uint32 count = 0;
+		for (uint32 i = 0; i < MT_STACK_USAGE_MAX_TASK_TYPES && count < maxCount; i++)
+		{
+			const TaskStackUsageSlot& slot = taskStackUsage[i];
+
+			void* taskFunc = slot.taskFunc.Load();
+			if (taskFunc == nullptr)
+			{
+				continue;
 			}
+
+			TaskStackUsage& item = items[count];
+			item.taskFunc = (TTaskEntryPoint)taskFunc;
+			item.debugID = slot.debugID;
+			item.stackRequirements = slot.stackRequirements;
+			item.peakBytes = slot.peakBytes.Load();
+			count++;
 		}
-		for (uint32 i = 0; i < waitingThreads.size(); i++)
+		return count;
+	}
+#endif
+
+	uint32 TaskScheduler::GetNumaNodesCount() const
+	{
+		return numaNodesCount;
+	}
+
+	uint32 TaskScheduler::GetTaskQueueCapacity() const
+	{
+		return taskQueueCapacity;
+	}
+
+	uint32 TaskScheduler::GetFibersCount(StackRequirements::Type stackRequirements) const
+	{
+		return GetFiberPool(stackRequirements).GetMaxCount();
+	}
+
+	uint32 TaskScheduler::GetCreatedFibersCount(StackRequirements::Type stackRequirements) const
+	{
+		return GetFiberPool(stackRequirements).GetCreatedCount();
+	}
+
+	uint32 TaskScheduler::GetPeakFibersInUseCount(StackRequirements::Type stackRequirements) const
+	{
+		return GetFiberPool(stackRequirements).GetPeakInUseCount();
+	}
+
+	bool TaskScheduler::IsWorkerThread() const
+	{
+		internal::ThreadContext* context = currentWorkerContext;
+		if (context != nullptr && context->taskScheduler == this)
 		{
-			if (waitingThreads[i].IsEqual(ThreadId::Self()))
-				return true;
+			return true;
 		}
 
-		return false;
+		// External thread which is executing tasks while waiting
+		return (currentWaitingScheduler == this);
 	}
 
 	TaskGroup TaskScheduler::CreateGroup()
@@ -44,36 +44,86 @@ namespace MT
 			: lastActiveFiberContext(nullptr)
 			, taskScheduler(nullptr)
 			, hasNewTasksEvent(EventReset::AUTOMATIC, true)
+			, isParked(0)
 			, state(ThreadState::ALIVE)
+			, descBuffer(nullptr)
 			, workerIndex(0)
+			, victims(nullptr)
+			, victimDistances(nullptr)
+			, victimsCount(0)
+			, isVictimOrderRandomized(true)
+			, thieves(nullptr)
+			, thievesCount(0)
 			, isExternalDescBuffer(false)
+			, nodeIndex(0)
 		{
-			 descBuffer = Memory::Alloc( GetMemoryRequrementInBytesForDescBuffer() );
+			for(uint32 i = 0; i < StealDistance::COUNT; i++)
+			{
+				stealDistanceHistogram[i].StoreRelaxed(0);
+			}
 		}
 
 		ThreadContext::ThreadContext(void* externalDescBuffer)
 			: lastActiveFiberContext(nullptr)
 			, taskScheduler(nullptr)
-			, queue(DummyQueueFlag::IS_DUMMY_QUEUE)
+			, isParked(0)
 			, state(ThreadState::ALIVE)
 			, workerIndex(0)
+			, victims(nullptr)
+			, victimDistances(nullptr)
+			, victimsCount(0)
+			, isVictimOrderRandomized(true)
+			, thieves(nullptr)
+			, thievesCount(0)
 			, isExternalDescBuffer(true)
+			, nodeIndex(0)
 		{
 			descBuffer = externalDescBuffer;
+
+			for(uint32 i = 0; i < StealDistance::COUNT; i++)
+			{
+				stealDistanceHistogram[i].StoreRelaxed(0);
+			}
 		}
 
 		ThreadContext::~ThreadContext()
 		{
-			if (isExternalDescBuffer == false)
+			if (isExternalDescBuffer == false && descBuffer != nullptr)
 			{
 				Memory::Free(descBuffer);
 			}
 			descBuffer = nullptr;
+
+			SetVictimsCount(0);
+			SetThievesCount(0);
+		}
+
+		void ThreadContext::CreateTaskQueue(uint32 taskQueueCapacity, void* externalMemory)
+		{
+			MT_ASSERT(isExternalDescBuffer == false && descBuffer == nullptr, "Task queue already created");
+
+			if (externalMemory == nullptr)
+			{
+				queue.Create(taskQueueCapacity);
+				descBuffer = Memory::Alloc( GetMemoryRequrementInBytesForDescBuffer(taskQueueCapacity) );
+				return;
+			}
+
+			// Queue storage first, temporary buffer right after it
+			queue.Create(taskQueueCapacity, externalMemory);
+			descBuffer = (char*)externalMemory + AlignUp(TaskQueue::GetMemoryRequrementInBytes(taskQueueCapacity), 64);
+			isExternalDescBuffer = true;
 		}
 
-		size_t ThreadContext::GetMemoryRequrementInBytesForDescBuffer()
+		size_t ThreadContext::GetMemoryRequrementInBytesForDescBuffer(uint32 taskQueueCapacity)
 		{
-			return sizeof(internal::GroupedTask) * TASK_BUFFER_CAPACITY;
+			return sizeof(internal::GroupedTask) * taskQueueCapacity;
+		}
+
+		size_t ThreadContext::GetMemoryRequrementInBytesForTaskQueue(uint32 taskQueueCapacity)
+		{
+			size_t queueBytesCount = AlignUp(TaskQueue::GetMemoryRequrementInBytes(taskQueueCapacity), 64);
+			return AlignUp(queueBytesCount + GetMemoryRequrementInBytesForDescBuffer(taskQueueCapacity), 64);
 		}
 
 		void ThreadContext::SetThreadIndex(uint32 threadIndex)
@@ -82,6 +132,43 @@ namespace MT
 			random.SetSeed( GetPrimeNumber(threadIndex) );
 		}
 
+		void ThreadContext::SetVictimsCount(uint32 count)
+		{
+			if (victims != nullptr)
+			{
+				Memory::Free(victims);
+				victims = nullptr;
+			}
+
+			if (victimDistances != nullptr)
+			{
+				Memory::Free(victimDistances);
+				victimDistances = nullptr;
+			}
+
+			victimsCount = count;
+			if (count > 0)
+			{
+				victims = (uint32*)Memory::Alloc(sizeof(uint32) * count);
+				victimDistances = (uint8*)Memory::Alloc(sizeof(uint8) * count);
+			}
+		}
+
+		void ThreadContext::SetThievesCount(uint32 count)
+		{
+			if (thieves != nullptr)
+			{
+				Memory::Free(thieves);
+				thieves = nullptr;
+			}
+
+			thievesCount = count;
+			if (count > 0)
+			{
+				thieves = (uint32*)Memory::Alloc(sizeof(uint32) * count);
+			}
+		}
+
 #ifdef MT_INSTRUMENTED_BUILD
 
 		void ThreadContext::NotifyWaitStarted()
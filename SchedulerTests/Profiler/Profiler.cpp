@@ -1,5 +1,6 @@
 #include <MTScheduler.h>
 #include "Profiler.h"
+#include <vector>
 
 
 #if defined(MT_INSTRUMENTED_BUILD) && defined(MT_ENABLE_BROFILER_SUPPORT)
@@ -13,7 +14,8 @@ const char *g_WorkerNames[MAX_INSTRUMENTED_WORKERS] = {"worker0","worker1","work
 
 class ProfilerEventListener : public MT::IProfilerEventListener
 {
-	Brofiler::EventStorage* fiberEventStorages[MT::MT_MAX_STANDART_FIBERS_COUNT + MT::MT_MAX_EXTENDED_FIBERS_COUNT];
+	// Fibers count is defined by SchedulerConfig, storage slots must not move after registration
+	std::vector<Brofiler::EventStorage*> fiberEventStorages;
 	uint32 totalFibersCount;
 
 	static mt_thread_local Brofiler::EventStorage* originalThreadStorage;
@@ -29,7 +31,8 @@ public:
 	virtual void OnFibersCreated(uint32 fibersCount) override
 	{
 		totalFibersCount = fibersCount;
-		MT_ASSERT(fibersCount <= MT_ARRAY_SIZE(fiberEventStorages), "Too many fibers!");
+		MT_ASSERT(fiberEventStorages.empty(), "Fibers already registered!");
+		fiberEventStorages.resize(fibersCount, nullptr);
 		for(uint32 fiberIndex = 0; fiberIndex < fibersCount; fiberIndex++)
 		{
 			Brofiler::RegisterFiber(fiberIndex, &fiberEventStorages[fiberIndex]);
@@ -0,0 +1,684 @@
+// The MIT License (MIT)
+//
+// 	Copyright (c) 2015 Sergey Makeev, Vadim Slyusarev
+//
+// 	Permission is hereby granted, free of charge, to any person obtaining a copy
+// 	of this software and associated documentation files (the "Software"), to deal
+// 	in the Software without restriction, including without limitation the rights
+// 	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// 	copies of the Software, and to permit persons to whom the Software is
+// 	furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+// 	all copies or substantial portions of the Software.
+//
+// 	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// 	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// 	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// 	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// 	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// 	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// 	THE SOFTWARE.
+
+#include "Tests.h"
+#include <UnitTest++.h>
+#include <MTScheduler.h>
+
+SUITE(FiberSyncTests)
+{
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace FiberMutexTests
+{
+	static const int CONTENDER_COUNT = 16;
+	static const int BACKGROUND_COUNT = 32;
+
+	MT::FiberMutex* mutex = nullptr;
+	MT::TaskGroup backgroundGroup;
+
+	MT::Atomic32<int32> isHolderFinished(0);
+	MT::Atomic32<int32> backgroundCount(0);
+	MT::Atomic32<int32> contenderCount(0);
+	MT::Atomic32<int32> errorsCount(0);
+
+	struct BackgroundTask
+	{
+		MT_DECLARE_TASK(BackgroundTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext&)
+		{
+			backgroundCount.IncFetch();
+		}
+	};
+
+	struct ContenderTask
+	{
+		MT_DECLARE_TASK(ContenderTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			mutex->Lock(ctx);
+
+			if (isHolderFinished.Load() == 0)
+			{
+				errorsCount.IncFetch();
+			}
+			contenderCount.IncFetch();
+
+			mutex->Unlock();
+		}
+	};
+
+	struct HolderTask
+	{
+		MT_DECLARE_TASK(HolderTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		BackgroundTask backgroundTasks[BACKGROUND_COUNT];
+		ContenderTask contenders[CONTENDER_COUNT];
+
+		void Do(MT::FiberContext& ctx)
+		{
+			mutex->Lock(ctx);
+
+			// Worker runs contenders and background tasks while the mutex is locked
+			ctx.RunAsync(MT::TaskGroup::Default(), &contenders[0], CONTENDER_COUNT);
+			ctx.RunAsync(backgroundGroup, &backgroundTasks[0], BACKGROUND_COUNT);
+			ctx.WaitGroupAndYield(backgroundGroup);
+
+			if (backgroundCount.Load() != BACKGROUND_COUNT || contenderCount.Load() != 0)
+			{
+				errorsCount.IncFetch();
+			}
+
+			isHolderFinished.Store(1);
+			mutex->Unlock();
+		}
+	};
+
+	// One worker would be blocked forever if contended Lock was blocking the thread
+	TEST(FiberMutexOneWorker)
+	{
+		MT::TaskScheduler scheduler(1);
+
+		MT::FiberMutex fiberMutex;
+		mutex = &fiberMutex;
+		backgroundGroup = scheduler.CreateGroup();
+
+		isHolderFinished.Store(0);
+		backgroundCount.Store(0);
+		contenderCount.Store(0);
+		errorsCount.Store(0);
+
+		HolderTask holder;
+		scheduler.RunAsync(MT::TaskGroup::Default(), &holder, 1);
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL(CONTENDER_COUNT, contenderCount.Load());
+		CHECK_EQUAL(0, errorsCount.Load());
+
+		scheduler.ReleaseGroup(backgroundGroup);
+		mutex = nullptr;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static const int INCREMENT_COUNT = 100;
+
+	int32 protectedValue = 0;
+
+	struct IncrementTask
+	{
+		MT_DECLARE_TASK(IncrementTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			for (int i = 0; i < INCREMENT_COUNT; i++)
+			{
+				if (mutex->TryLock() == false)
+				{
+					mutex->Lock(ctx);
+				}
+
+				// Owner is rescheduled while holding the mutex, other tasks are suspended on it meanwhile
+				int32 value = protectedValue;
+				if ((i & 15) == 0)
+				{
+					ctx.Yield();
+				}
+				protectedValue = value + 1;
+
+				mutex->Unlock();
+			}
+		}
+	};
+
+	TEST(FiberMutexStress)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		MT::FiberMutex fiberMutex;
+		mutex = &fiberMutex;
+		protectedValue = 0;
+
+		IncrementTask tasks[64];
+		scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL((int32)MT_ARRAY_SIZE(tasks) * INCREMENT_COUNT, protectedValue);
+
+		mutex = nullptr;
+	}
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace FiberSemaphoreTests
+{
+	static const int32 UNITS_COUNT = 3;
+
+	MT::FiberSemaphore* semaphore = nullptr;
+
+	MT::Atomic32<int32> inProgressCount(0);
+	MT::Atomic32<int32> maxInProgressCount(0);
+	MT::Atomic32<int32> finishedCount(0);
+
+	struct LimitedTask
+	{
+		MT_DECLARE_TASK(LimitedTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			semaphore->Acquire(ctx);
+
+			int32 count = inProgressCount.IncFetch();
+			for(;;)
+			{
+				int32 maxCount = maxInProgressCount.Load();
+				if (count <= maxCount || maxInProgressCount.CompareAndSwap(maxCount, count) == maxCount)
+				{
+					break;
+				}
+			}
+
+			// Let other tasks run into the semaphore
+			ctx.Yield();
+			MT::SpinSleepMicroSeconds(10);
+
+			inProgressCount.DecFetch();
+			finishedCount.IncFetch();
+
+			semaphore->Release();
+		}
+	};
+
+	void RunLimitedTasks(MT::TaskScheduler& scheduler)
+	{
+		MT::FiberSemaphore fiberSemaphore(UNITS_COUNT);
+		semaphore = &fiberSemaphore;
+
+		inProgressCount.Store(0);
+		maxInProgressCount.Store(0);
+		finishedCount.Store(0);
+
+		LimitedTask tasks[128];
+		scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL((int32)MT_ARRAY_SIZE(tasks), finishedCount.Load());
+		CHECK(maxInProgressCount.Load() <= UNITS_COUNT);
+
+		// All units are returned
+		for (int32 i = 0; i < UNITS_COUNT; i++)
+		{
+			CHECK(fiberSemaphore.TryAcquire());
+		}
+		CHECK_EQUAL(false, fiberSemaphore.TryAcquire());
+		fiberSemaphore.Release(UNITS_COUNT);
+
+		semaphore = nullptr;
+	}
+
+	TEST(FiberSemaphoreOneWorker)
+	{
+		MT::TaskScheduler scheduler(1);
+		RunLimitedTasks(scheduler);
+	}
+
+	TEST(FiberSemaphoreStress)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+		RunLimitedTasks(scheduler);
+	}
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace FiberConditionVariableTests
+{
+	static const int ITEMS_PER_PRODUCER = 8;
+	static const int ITEMS_PER_CONSUMER = 4;
+	static const int PRODUCER_COUNT = 16;
+	static const int CONSUMER_COUNT = PRODUCER_COUNT * ITEMS_PER_PRODUCER / ITEMS_PER_CONSUMER;
+
+	MT::FiberMutex* mutex = nullptr;
+	MT::FiberConditionVariable* itemsAvailable = nullptr;
+
+	int32 itemsCount = 0;
+	MT::Atomic32<int32> consumedCount(0);
+
+	struct ProducerTask
+	{
+		MT_DECLARE_TASK(ProducerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			for (int i = 0; i < ITEMS_PER_PRODUCER; i++)
+			{
+				mutex->Lock(ctx);
+				itemsCount++;
+				mutex->Unlock();
+
+				itemsAvailable->NotifyOne();
+			}
+		}
+	};
+
+	struct ConsumerTask
+	{
+		MT_DECLARE_TASK(ConsumerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			for (int i = 0; i < ITEMS_PER_CONSUMER; i++)
+			{
+				mutex->Lock(ctx);
+				while (itemsCount == 0)
+				{
+					itemsAvailable->Wait(ctx, *mutex);
+				}
+				itemsCount--;
+				mutex->Unlock();
+
+				consumedCount.IncFetch();
+			}
+		}
+	};
+
+	void RunProducersAndConsumers(MT::TaskScheduler& scheduler)
+	{
+		MT::FiberMutex fiberMutex;
+		MT::FiberConditionVariable conditionVariable;
+		mutex = &fiberMutex;
+		itemsAvailable = &conditionVariable;
+
+		itemsCount = 0;
+		consumedCount.Store(0);
+
+		// Consumers are submitted first and wait for items
+		ConsumerTask consumers[CONSUMER_COUNT];
+		scheduler.RunAsync(MT::TaskGroup::Default(), &consumers[0], MT_ARRAY_SIZE(consumers));
+
+		ProducerTask producers[PRODUCER_COUNT];
+		scheduler.RunAsync(MT::TaskGroup::Default(), &producers[0], MT_ARRAY_SIZE(producers));
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL(PRODUCER_COUNT * ITEMS_PER_PRODUCER, consumedCount.Load());
+		CHECK_EQUAL(0, itemsCount);
+
+		mutex = nullptr;
+		itemsAvailable = nullptr;
+	}
+
+	TEST(FiberConditionVariableOneWorker)
+	{
+		MT::TaskScheduler scheduler(1);
+		RunProducersAndConsumers(scheduler);
+	}
+
+	TEST(FiberConditionVariableStress)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		for (int round = 0; round < 20; round++)
+		{
+			RunProducersAndConsumers(scheduler);
+		}
+	}
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace FiberRWLockTests
+{
+	static const int ITERATIONS_COUNT = 32;
+
+	MT::FiberRWLock* rwLock = nullptr;
+
+	// Writers keep the values equal
+	int32 valueA = 0;
+	int32 valueB = 0;
+
+	MT::Atomic32<int32> readersCount(0);
+	MT::Atomic32<int32> errorsCount(0);
+
+	struct WriterTask
+	{
+		MT_DECLARE_TASK(WriterTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			for (int i = 0; i < ITERATIONS_COUNT; i++)
+			{
+				rwLock->Lock(ctx);
+
+				if (readersCount.Load() != 0)
+				{
+					errorsCount.IncFetch();
+				}
+
+				valueA++;
+
+				// Readers and writers are suspended while the lock is held
+				if ((i & 3) == 0)
+				{
+					ctx.Yield();
+				}
+
+				valueB++;
+
+				rwLock->Unlock();
+			}
+		}
+	};
+
+	struct ReaderTask
+	{
+		MT_DECLARE_TASK(ReaderTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			for (int i = 0; i < ITERATIONS_COUNT; i++)
+			{
+				rwLock->LockShared(ctx);
+
+				readersCount.IncFetch();
+
+				if (valueA != valueB)
+				{
+					errorsCount.IncFetch();
+				}
+
+				// Other readers can share the lock meanwhile
+				if ((i & 3) == 0)
+				{
+					ctx.Yield();
+				}
+
+				if (valueA != valueB)
+				{
+					errorsCount.IncFetch();
+				}
+
+				readersCount.DecFetch();
+				rwLock->UnlockShared();
+			}
+		}
+	};
+
+	void RunReadersAndWriters(MT::TaskScheduler& scheduler)
+	{
+		MT::FiberRWLock fiberRWLock;
+		rwLock = &fiberRWLock;
+
+		valueA = 0;
+		valueB = 0;
+		readersCount.Store(0);
+		errorsCount.Store(0);
+
+		WriterTask writers[8];
+		ReaderTask readers[32];
+		scheduler.RunAsync(MT::TaskGroup::Default(), &readers[0], MT_ARRAY_SIZE(readers) / 2);
+		scheduler.RunAsync(MT::TaskGroup::Default(), &writers[0], MT_ARRAY_SIZE(writers));
+		scheduler.RunAsync(MT::TaskGroup::Default(), &readers[MT_ARRAY_SIZE(readers) / 2], MT_ARRAY_SIZE(readers) / 2);
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL(0, errorsCount.Load());
+		CHECK_EQUAL((int32)MT_ARRAY_SIZE(writers) * ITERATIONS_COUNT, valueA);
+		CHECK_EQUAL(valueA, valueB);
+
+		rwLock = nullptr;
+	}
+
+	TEST(FiberRWLockOneWorker)
+	{
+		MT::TaskScheduler scheduler(1);
+		RunReadersAndWriters(scheduler);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	MT::TaskGroup nestedReadersGroup;
+
+	struct NestedReaderTask
+	{
+		MT_DECLARE_TASK(NestedReaderTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			rwLock->LockShared(ctx);
+			readersCount.IncFetch();
+			rwLock->UnlockShared();
+		}
+	};
+
+	struct SharedHolderTask
+	{
+		MT_DECLARE_TASK(SharedHolderTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		NestedReaderTask nestedReaders[16];
+
+		void Do(MT::FiberContext& ctx)
+		{
+			rwLock->LockShared(ctx);
+
+			// Readers get the lock while it is held by this task, otherwise the wait would never end
+			ctx.RunAsync(nestedReadersGroup, &nestedReaders[0], MT_ARRAY_SIZE(nestedReaders));
+			ctx.WaitGroupAndYield(nestedReadersGroup);
+
+			rwLock->UnlockShared();
+		}
+	};
+
+	TEST(FiberRWLockSharedByReaders)
+	{
+		MT::TaskScheduler scheduler(1);
+
+		MT::FiberRWLock fiberRWLock;
+		rwLock = &fiberRWLock;
+		nestedReadersGroup = scheduler.CreateGroup();
+		readersCount.Store(0);
+
+		SharedHolderTask holder;
+		scheduler.RunAsync(MT::TaskGroup::Default(), &holder, 1);
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL((int32)MT_ARRAY_SIZE(holder.nestedReaders), readersCount.Load());
+
+		scheduler.ReleaseGroup(nestedReadersGroup);
+		rwLock = nullptr;
+	}
+
+	TEST(FiberRWLockStress)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+		RunReadersAndWriters(scheduler);
+	}
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace DestroyedByWaiter
+{
+	static const int WAITER_COUNT = 16;
+	static const int ROUND_COUNT = 200;
+
+	// Primitives are owned by the waiters, the last resumed waiter destroys them
+	MT::FiberMutex* mutex = nullptr;
+	MT::FiberConditionVariable* conditionVariable = nullptr;
+	MT::FiberRWLock* rwLock = nullptr;
+
+	bool isReady = false;
+	MT::Atomic32<int32> remainingCount(0);
+	MT::Atomic32<int32> isLockedByWriter(0);
+	MT::Atomic32<int32> areReadersStarted(0);
+
+	struct NotifierTask
+	{
+		MT_DECLARE_TASK(NotifierTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			// Objects can be deleted as soon as the waiters are resumed, so they are read before
+			MT::FiberMutex* notifierMutex = mutex;
+			MT::FiberConditionVariable* notifierConditionVariable = conditionVariable;
+
+			notifierMutex->Lock(ctx);
+			isReady = true;
+			notifierMutex->Unlock();
+
+			notifierConditionVariable->NotifyAll();
+		}
+	};
+
+	struct ConditionWaiterTask
+	{
+		MT_DECLARE_TASK(ConditionWaiterTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			MT::FiberMutex* waiterMutex = mutex;
+
+			waiterMutex->Lock(ctx);
+			while (isReady == false)
+			{
+				conditionVariable->Wait(ctx, *waiterMutex);
+			}
+			waiterMutex->Unlock();
+
+			if (remainingCount.DecFetch() == 0)
+			{
+				delete conditionVariable;
+				conditionVariable = nullptr;
+				delete mutex;
+				mutex = nullptr;
+			}
+		}
+	};
+
+	TEST(ConditionVariableDestroyedByWaiter)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		for (int round = 0; round < ROUND_COUNT; round++)
+		{
+			mutex = new MT::FiberMutex();
+			conditionVariable = new MT::FiberConditionVariable();
+			isReady = false;
+			remainingCount.Store(WAITER_COUNT);
+
+			ConditionWaiterTask waiters[WAITER_COUNT];
+			scheduler.RunAsync(MT::TaskGroup::Default(), &waiters[0], MT_ARRAY_SIZE(waiters));
+
+			NotifierTask notifier;
+			scheduler.RunAsync(MT::TaskGroup::Default(), &notifier, 1);
+
+			CHECK(scheduler.WaitAll(20000));
+			CHECK(mutex == nullptr && conditionVariable == nullptr);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct WriterTask
+	{
+		MT_DECLARE_TASK(WriterTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			MT::FiberRWLock* writerLock = rwLock;
+
+			writerLock->Lock(ctx);
+			isLockedByWriter.Store(1);
+
+			// Readers come while the lock is held
+			while (areReadersStarted.Load() == 0)
+			{
+				ctx.Yield();
+			}
+
+			writerLock->Unlock();
+		}
+	};
+
+	struct ReaderTask
+	{
+		MT_DECLARE_TASK(ReaderTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			MT::FiberRWLock* readerLock = rwLock;
+
+			readerLock->LockShared(ctx);
+			readerLock->UnlockShared();
+
+			if (remainingCount.DecFetch() == 0)
+			{
+				delete rwLock;
+				rwLock = nullptr;
+			}
+		}
+	};
+
+	struct StartReadersTask
+	{
+		MT_DECLARE_TASK(StartReadersTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		ReaderTask readers[WAITER_COUNT];
+
+		void Do(MT::FiberContext& ctx)
+		{
+			while (isLockedByWriter.Load() == 0)
+			{
+				ctx.Yield();
+			}
+
+			ctx.RunAsync(MT::TaskGroup::Default(), &readers[0], WAITER_COUNT);
+
+			// Some readers are suspended by now, the rest are suspended or done after the writer
+			MT::SpinSleepMicroSeconds(50);
+			areReadersStarted.Store(1);
+		}
+	};
+
+	TEST(RWLockDestroyedByReader)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		for (int round = 0; round < ROUND_COUNT; round++)
+		{
+			rwLock = new MT::FiberRWLock();
+			isLockedByWriter.Store(0);
+			areReadersStarted.Store(0);
+			remainingCount.Store(WAITER_COUNT);
+
+			WriterTask writer;
+			scheduler.RunAsync(MT::TaskGroup::Default(), &writer, 1);
+
+			StartReadersTask startReaders;
+			scheduler.RunAsync(MT::TaskGroup::Default(), &startReaders, 1);
+
+			CHECK(scheduler.WaitAll(20000));
+			CHECK(rwLock == nullptr);
+		}
+	}
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+}
+
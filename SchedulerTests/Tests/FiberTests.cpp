@@ -106,4 +106,67 @@ TEST(FiberSimpleTest)
     printf("Fiber test done\n");
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if MT_PLATFORM_POSIX
+	template<typename FIBER>
+	struct FiberPingPong
+	{
+		static const int ITERATIONS_COUNT = 1000000;
+
+		FIBER threadFiber;
+		FIBER pongFiber;
+		int pongCount;
+
+		FiberPingPong()
+			: pongCount(0)
+		{
+		}
+
+		static void PongFiberFunc(void* userData)
+		{
+			FiberPingPong* self = (FiberPingPong*)userData;
+			for(;;)
+			{
+				self->pongCount++;
+				FIBER::SwitchTo(self->pongFiber, self->threadFiber);
+			}
+		}
+
+		static void PingFiberFunc(void* userData)
+		{
+			FiberPingPong* self = (FiberPingPong*)userData;
+			self->pongFiber.Create(SMALLEST_STACK_SIZE, PongFiberFunc, self);
+
+			int64 startTime = MT::GetTimeMicroSeconds();
+			for(int i = 0; i < ITERATIONS_COUNT; i++)
+			{
+				FIBER::SwitchTo(self->threadFiber, self->pongFiber);
+			}
+			int64 totalTime = MT::GetTimeMicroSeconds() - startTime;
+
+			CHECK_EQUAL((int)ITERATIONS_COUNT, self->pongCount);
+
+			// two switches per iteration
+			printf("nanoseconds per switch = %3.2f\n", (double)totalTime * 1000.0 / (double)(ITERATIONS_COUNT * 2));
+		}
+
+		static void Run(const char* name)
+		{
+			printf("%s: ", name);
+
+			FiberPingPong pingPong;
+			pingPong.threadFiber.CreateFromCurrentThreadAndRun(PingFiberFunc, &pingPong);
+		}
+	};
+
+// Compares fiber switch time of available fiber implementations
+TEST(FiberSwitchBenchmark)
+{
+	FiberPingPong<MT::FiberUContext>::Run("ucontext fiber");
+#if MT_ENABLE_ASM_FIBER_SWITCH
+	FiberPingPong<MT::FiberAsm>::Run("asm fiber");
+#endif
+}
+#endif
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 }
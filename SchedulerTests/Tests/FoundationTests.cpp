@@ -24,6 +24,8 @@
 #include <UnitTest++.h>
 #include <MTScheduler.h>
 #include <MTQueueMPMC.h>
+#include <MTWorkStealingQueue.h>
+#include <MTBatchQueueMPSC.h>
 #include <MTConcurrentRingBuffer.h>
 #include <MTArrayView.h>
 #include <MTStaticVector.h>
@@ -95,7 +97,7 @@ TEST(StackArrayTest)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST(QueueMPMC_BasicTest)
 {
-	MT::LockFreeQueueMPMC<int, 32> queue;
+	MT::LockFreeQueueMPMC<int> queue(32);
 
 	for(int i = 0; i < 64; i++)
 	{
@@ -155,6 +157,365 @@ TEST(QueueMPMC_BasicTest)
 
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(WorkStealingQueue_BasicTest)
+{
+	MT::WorkStealingQueue<int> queue;
+
+	int v = -133;
+	CHECK_EQUAL(false, queue.TryPop(v));
+	CHECK_EQUAL(false, queue.TrySteal(v));
+	CHECK_EQUAL(-133, v);
+
+	queue.Create(32);
+
+	// capacity - 1 items can be stored
+	for(int i = 0; i < 64; i++)
+	{
+		int item = 77 + i;
+		bool res = queue.Push(&item, 1);
+		CHECK_EQUAL(i < 31, res);
+	}
+
+	CHECK_EQUAL((uint32)31, queue.Size());
+
+	// owner pops newest items
+	CHECK_EQUAL(true, queue.TryPop(v));
+	CHECK_EQUAL(77 + 30, v);
+	CHECK_EQUAL(true, queue.TryPop(v));
+	CHECK_EQUAL(77 + 29, v);
+
+	// thieves steal oldest items
+	CHECK_EQUAL(true, queue.TrySteal(v));
+	CHECK_EQUAL(77, v);
+	CHECK_EQUAL(true, queue.TrySteal(v));
+	CHECK_EQUAL(78, v);
+
+	for(int i = 0; i < 27; i++)
+	{
+		CHECK_EQUAL(true, queue.TryPop(v));
+		CHECK_EQUAL(77 + 28 - i, v);
+	}
+
+	CHECK_EQUAL(false, queue.TryPop(v));
+	CHECK_EQUAL(false, queue.TrySteal(v));
+	CHECK_EQUAL((uint32)0, queue.Size());
+
+	int items[3] = { 113, 114, 115 };
+	CHECK_EQUAL(true, queue.Push(&items[0], 3));
+	CHECK_EQUAL(true, queue.TrySteal(v));
+	CHECK_EQUAL(113, v);
+	CHECK_EQUAL(true, queue.TryPop(v));
+	CHECK_EQUAL(115, v);
+	CHECK_EQUAL(true, queue.TryPop(v));
+	CHECK_EQUAL(114, v);
+	CHECK_EQUAL(false, queue.TryPop(v));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(WorkStealingQueue_StealHalfTest)
+{
+	MT::WorkStealingQueue<int> queue;
+
+	int stolen[32];
+	CHECK_EQUAL((uint32)0, queue.TryStealHalf(stolen, MT_ARRAY_SIZE(stolen)));
+
+	queue.Create(32);
+	CHECK_EQUAL((uint32)0, queue.TryStealHalf(stolen, MT_ARRAY_SIZE(stolen)));
+
+	int items[11] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	CHECK_EQUAL(true, queue.Push(&items[0], MT_ARRAY_SIZE(items)));
+
+	// thief takes half of the queue (rounded up), oldest items first
+	CHECK_EQUAL((uint32)6, queue.TryStealHalf(stolen, MT_ARRAY_SIZE(stolen)));
+	for(int i = 0; i < 6; i++)
+	{
+		CHECK_EQUAL(i, stolen[i]);
+	}
+
+	// batch size limit
+	CHECK_EQUAL((uint32)2, queue.TryStealHalf(stolen, 2));
+	CHECK_EQUAL(6, stolen[0]);
+	CHECK_EQUAL(7, stolen[1]);
+
+	CHECK_EQUAL((uint32)2, queue.TryStealHalf(stolen, MT_ARRAY_SIZE(stolen)));
+	CHECK_EQUAL(8, stolen[0]);
+	CHECK_EQUAL(9, stolen[1]);
+
+	// last item can be stolen too
+	CHECK_EQUAL((uint32)1, queue.TryStealHalf(stolen, MT_ARRAY_SIZE(stolen)));
+	CHECK_EQUAL(10, stolen[0]);
+
+	int v = -1;
+	CHECK_EQUAL(false, queue.TryPop(v));
+	CHECK_EQUAL((uint32)0, queue.Size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace WorkStealingQueueStress
+{
+	static const int ITEMS_COUNT = 100000;
+	static const uint32 THIEVES_COUNT = 3;
+
+	MT::WorkStealingQueue<int> queue;
+	MT::Atomic32<int32> isFinished;
+	MT::Atomic32<int32> stolenCount;
+	MT::Atomic32<int32> consumedCount[ITEMS_COUNT];
+
+	void ThiefThreadFunc(void*)
+	{
+		while(isFinished.Load() == 0)
+		{
+			int items[8];
+			uint32 count = queue.TryStealHalf(items, MT_ARRAY_SIZE(items));
+			for(uint32 i = 0; i < count; i++)
+			{
+				consumedCount[items[i]].IncFetch();
+				stolenCount.IncFetch();
+			}
+
+			if (count == 0)
+			{
+				MT::YieldThread();
+			}
+		}
+	}
+
+	TEST(WorkStealingQueue_StressTest)
+	{
+		if (!queue.IsCreated())
+		{
+			queue.Create(256);
+		}
+
+		isFinished.Store(0);
+		stolenCount.Store(0);
+
+		for(int i = 0; i < ITEMS_COUNT; i++)
+		{
+			consumedCount[i].Store(0);
+		}
+
+		MT::Thread thieves[THIEVES_COUNT];
+		for(uint32 i = 0; i < THIEVES_COUNT; i++)
+		{
+			thieves[i].Start(32768, ThiefThreadFunc, nullptr);
+		}
+
+		// owner adds items and pops some of them, thieves steal the rest
+		int v = -1;
+		for(int i = 0; i < ITEMS_COUNT; i++)
+		{
+			while(queue.Push(&i, 1) == false)
+			{
+				MT::YieldProcessor();
+			}
+
+			if ((i % 3) == 0 && queue.TryPop(v))
+			{
+				consumedCount[v].IncFetch();
+			}
+		}
+
+		while(queue.TryPop(v))
+		{
+			consumedCount[v].IncFetch();
+		}
+
+		isFinished.Store(1);
+		for(uint32 i = 0; i < THIEVES_COUNT; i++)
+		{
+			thieves[i].Join();
+		}
+
+		// every item must be consumed exactly once
+		int invalidCount = 0;
+		for(int i = 0; i < ITEMS_COUNT; i++)
+		{
+			if (consumedCount[i].Load() != 1)
+			{
+				invalidCount++;
+			}
+		}
+
+		CHECK_EQUAL(0, invalidCount);
+		printf("WorkStealingQueue stress: %d items, %d stolen\n", ITEMS_COUNT, stolenCount.Load());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(BatchQueueMPSC_BasicTest)
+{
+	MT::BatchQueueMPSC<int> queue;
+
+	int items[8];
+	CHECK_EQUAL(true, queue.IsEmpty());
+	CHECK_EQUAL((size_t)0, queue.TryPop(items, MT_ARRAY_SIZE(items)));
+
+	int batch0[3] = { 1, 2, 3 };
+	int batch1[2] = { 4, 5 };
+	queue.Push(batch0, MT_ARRAY_SIZE(batch0));
+	queue.Push(batch1, MT_ARRAY_SIZE(batch1));
+	CHECK_EQUAL(false, queue.IsEmpty());
+
+	// batch can be popped partially
+	CHECK_EQUAL((size_t)2, queue.TryPop(items, 2));
+	CHECK_EQUAL(1, items[0]);
+	CHECK_EQUAL(2, items[1]);
+
+	// and items can be popped from several batches at once
+	CHECK_EQUAL((size_t)3, queue.TryPop(items, MT_ARRAY_SIZE(items)));
+	CHECK_EQUAL(3, items[0]);
+	CHECK_EQUAL(4, items[1]);
+	CHECK_EQUAL(5, items[2]);
+
+	CHECK_EQUAL(true, queue.IsEmpty());
+	CHECK_EQUAL((size_t)0, queue.TryPop(items, MT_ARRAY_SIZE(items)));
+
+	// queue is unbounded
+	for(int i = 0; i < 10000; i++)
+	{
+		queue.Push(&i, 1);
+	}
+
+	int expected = 0;
+	while(size_t count = queue.TryPop(items, MT_ARRAY_SIZE(items)))
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			CHECK_EQUAL(expected, items[i]);
+			expected++;
+		}
+	}
+	CHECK_EQUAL(10000, expected);
+
+	// large batch is split into several nodes and keeps its order
+	int largeBatch[100];
+	for(int i = 0; i < (int)MT_ARRAY_SIZE(largeBatch); i++)
+	{
+		largeBatch[i] = i;
+	}
+	queue.Push(largeBatch, MT_ARRAY_SIZE(largeBatch));
+	CHECK_EQUAL(false, queue.IsEmpty());
+
+	expected = 0;
+	while(size_t count = queue.TryPop(items, MT_ARRAY_SIZE(items)))
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			CHECK_EQUAL(expected, items[i]);
+			expected++;
+		}
+	}
+	CHECK_EQUAL((int)MT_ARRAY_SIZE(largeBatch), expected);
+	CHECK_EQUAL(true, queue.IsEmpty());
+
+	// not consumed items are released by destructor
+	queue.Push(batch0, MT_ARRAY_SIZE(batch0));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace BatchQueueMPSCStress
+{
+	static const int ITEMS_PER_PRODUCER = 25000;
+	static const uint32 PRODUCERS_COUNT = 3;
+	static const uint32 CONSUMERS_COUNT = 2;
+
+	MT::BatchQueueMPSC<int> queue;
+	MT::Atomic32<int32> producedCount;
+	MT::Atomic32<int32> consumedCount[ITEMS_PER_PRODUCER * PRODUCERS_COUNT];
+
+	void ProducerThreadFunc(void* userData)
+	{
+		int producerIndex = (int)(intptr_t)userData;
+
+		int batch[7];
+		int index = 0;
+		while(index < ITEMS_PER_PRODUCER)
+		{
+			int count = MT::Min(1 + (index % (int)MT_ARRAY_SIZE(batch)), ITEMS_PER_PRODUCER - index);
+			for(int i = 0; i < count; i++)
+			{
+				batch[i] = producerIndex * ITEMS_PER_PRODUCER + index + i;
+			}
+
+			queue.Push(batch, count);
+			index += count;
+		}
+
+		producedCount.AddFetch(ITEMS_PER_PRODUCER);
+	}
+
+	void ConsumerThreadFunc(void*)
+	{
+		for(;;)
+		{
+			bool isProducersFinished = (producedCount.Load() == (int32)(ITEMS_PER_PRODUCER * PRODUCERS_COUNT));
+
+			int items[16];
+			size_t count = queue.TryPop(items, MT_ARRAY_SIZE(items));
+			for(size_t i = 0; i < count; i++)
+			{
+				consumedCount[items[i]].IncFetch();
+			}
+
+			if (count == 0)
+			{
+				if (isProducersFinished && queue.IsEmpty())
+				{
+					break;
+				}
+
+				MT::YieldThread();
+			}
+		}
+	}
+
+	TEST(BatchQueueMPSC_StressTest)
+	{
+		producedCount.Store(0);
+		for(uint32 i = 0; i < MT_ARRAY_SIZE(consumedCount); i++)
+		{
+			consumedCount[i].Store(0);
+		}
+
+		MT::Thread consumers[CONSUMERS_COUNT];
+		for(uint32 i = 0; i < CONSUMERS_COUNT; i++)
+		{
+			consumers[i].Start(32768, ConsumerThreadFunc, nullptr);
+		}
+
+		MT::Thread producers[PRODUCERS_COUNT];
+		for(uint32 i = 0; i < PRODUCERS_COUNT; i++)
+		{
+			producers[i].Start(32768, ProducerThreadFunc, (void*)(intptr_t)i);
+		}
+
+		for(uint32 i = 0; i < PRODUCERS_COUNT; i++)
+		{
+			producers[i].Join();
+		}
+
+		for(uint32 i = 0; i < CONSUMERS_COUNT; i++)
+		{
+			consumers[i].Join();
+		}
+
+		// every item must be consumed exactly once
+		int invalidCount = 0;
+		for(uint32 i = 0; i < MT_ARRAY_SIZE(consumedCount); i++)
+		{
+			if (consumedCount[i].Load() != 1)
+			{
+				invalidCount++;
+			}
+		}
+
+		CHECK_EQUAL(0, invalidCount);
+	}
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST(ArrayViewTest)
 {
@@ -141,5 +141,294 @@ namespace SimpleWaitFromSubtask
 	}
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace WaitGroupFromTask
+{
+	MT::Atomic32<int32> producedCount(0);
+	MT::Atomic32<int32> consumedCount(0);
+	MT::Atomic32<int32> earlyWakeUpCount(0);
+
+	static const int PRODUCER_COUNT = 64;
+
+	MT::TaskGroup groupEmpty;
+	MT::TaskGroup groupProducers;
+
+	struct ProducerTask
+	{
+		MT_DECLARE_TASK(ProducerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		uint32 workMicroSeconds;
+
+		ProducerTask()
+			: workMicroSeconds(20)
+		{
+		}
+
+		void Do(MT::FiberContext&)
+		{
+			MT::SpinSleepMicroSeconds(workMicroSeconds);
+			producedCount.IncFetch();
+		}
+	};
+
+	struct ConsumerTask
+	{
+		MT_DECLARE_TASK(ConsumerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			// Returns immediately
+			ctx.WaitGroupAndYield(groupEmpty);
+
+			ctx.WaitGroupAndYield(groupProducers);
+			if (producedCount.Load() != PRODUCER_COUNT)
+			{
+				earlyWakeUpCount.IncFetch();
+			}
+
+			consumedCount.IncFetch();
+		}
+	};
+
+	// Consumers wait for producers submitted later. One worker would be blocked forever if the wait was not yielding.
+	TEST(WaitGroupAndYieldOneWorker)
+	{
+		MT::TaskScheduler scheduler(1);
+
+		groupEmpty = scheduler.CreateGroup();
+		groupProducers = scheduler.CreateGroup();
+		MT::TaskGroup groupConsumers = scheduler.CreateGroup();
+
+		producedCount.Store(0);
+		consumedCount.Store(0);
+		earlyWakeUpCount.Store(0);
+
+		ConsumerTask consumers[8];
+		scheduler.RunAsync(groupConsumers, &consumers[0], MT_ARRAY_SIZE(consumers));
+
+		ProducerTask producers[PRODUCER_COUNT];
+		scheduler.RunAsync(groupProducers, &producers[0], MT_ARRAY_SIZE(producers));
+
+		CHECK(scheduler.WaitGroup(groupConsumers, 20000));
+		CHECK_EQUAL((int32)MT_ARRAY_SIZE(consumers), consumedCount.Load());
+		CHECK_EQUAL(0, earlyWakeUpCount.Load());
+
+		scheduler.ReleaseGroup(groupConsumers);
+		scheduler.ReleaseGroup(groupProducers);
+		scheduler.ReleaseGroup(groupEmpty);
+	}
+
+	// Producers finish while consumers are being suspended
+	TEST(WaitGroupAndYieldStress)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		groupEmpty = scheduler.CreateGroup();
+		groupProducers = scheduler.CreateGroup();
+		MT::TaskGroup groupConsumers = scheduler.CreateGroup();
+
+		static const int ROUND_COUNT = 200;
+		for (int round = 0; round < ROUND_COUNT; round++)
+		{
+			producedCount.Store(0);
+			consumedCount.Store(0);
+			earlyWakeUpCount.Store(0);
+
+			ProducerTask producers[PRODUCER_COUNT];
+			for (int i = 0; i < PRODUCER_COUNT; i++)
+			{
+				producers[i].workMicroSeconds = 0;
+			}
+			scheduler.RunAsync(groupProducers, &producers[0], MT_ARRAY_SIZE(producers));
+
+			ConsumerTask consumers[16];
+			scheduler.RunAsync(groupConsumers, &consumers[0], MT_ARRAY_SIZE(consumers));
+
+			CHECK(scheduler.WaitGroup(groupConsumers, 20000));
+			CHECK_EQUAL((int32)MT_ARRAY_SIZE(consumers), consumedCount.Load());
+			CHECK_EQUAL(0, earlyWakeUpCount.Load());
+		}
+
+		scheduler.ReleaseGroup(groupConsumers);
+		scheduler.ReleaseGroup(groupProducers);
+		scheduler.ReleaseGroup(groupEmpty);
+	}
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace WaitCounterFromTask
+{
+	MT::Atomic32<int32> finishedCount(0);
+	MT::Atomic32<int32> earlyWakeUpCount(0);
+
+	static const int SUBTASK_COUNT = 32;
+
+	struct LeafTask
+	{
+		MT_DECLARE_TASK(LeafTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		MT::Atomic32<int32>* doneCount;
+
+		LeafTask()
+			: doneCount(nullptr)
+		{
+		}
+
+		void Do(MT::FiberContext&)
+		{
+			doneCount->IncFetch();
+		}
+	};
+
+	struct JoinTask
+	{
+		MT_DECLARE_TASK(JoinTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			MT::TaskCounter emptyCounter;
+
+			// Returns immediately
+			ctx.WaitCounterAndYield(emptyCounter);
+
+			MT::Atomic32<int32> doneCount(0);
+			MT::TaskCounter counter;
+
+			LeafTask subtasks[SUBTASK_COUNT];
+			for (int i = 0; i < SUBTASK_COUNT; i++)
+			{
+				subtasks[i].doneCount = &doneCount;
+			}
+
+			// Join the first half, then the rest
+			ctx.RunAsync(MT::TaskGroup::Default(), &subtasks[0], SUBTASK_COUNT / 2, &counter);
+			ctx.RunAsync(MT::TaskGroup::Default(), &subtasks[SUBTASK_COUNT / 2], SUBTASK_COUNT / 2, &counter);
+
+			ctx.WaitCounterAndYield(counter, SUBTASK_COUNT / 2);
+			if (doneCount.Load() < SUBTASK_COUNT / 2)
+			{
+				earlyWakeUpCount.IncFetch();
+			}
+
+			ctx.WaitCounterAndYield(counter);
+			if (doneCount.Load() != SUBTASK_COUNT || counter.GetValue() != 0)
+			{
+				earlyWakeUpCount.IncFetch();
+			}
+
+			finishedCount.IncFetch();
+		}
+	};
+
+	// Each task joins its own subtasks, one worker would be blocked forever if the wait was not yielding.
+	TEST(WaitCounterAndYieldOneWorker)
+	{
+		MT::TaskScheduler scheduler(1);
+
+		finishedCount.Store(0);
+		earlyWakeUpCount.Store(0);
+
+		JoinTask tasks[8];
+		scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL((int32)MT_ARRAY_SIZE(tasks), finishedCount.Load());
+		CHECK_EQUAL(0, earlyWakeUpCount.Load());
+	}
+
+	// Counters reach their targets while the tasks are being suspended, task destroys the counter right after the wait
+	TEST(WaitCounterAndYieldStress)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		static const int ROUND_COUNT = 200;
+		for (int round = 0; round < ROUND_COUNT; round++)
+		{
+			finishedCount.Store(0);
+			earlyWakeUpCount.Store(0);
+
+			JoinTask tasks[16];
+			scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+			CHECK(scheduler.WaitAll(20000));
+			CHECK_EQUAL((int32)MT_ARRAY_SIZE(tasks), finishedCount.Load());
+			CHECK_EQUAL(0, earlyWakeUpCount.Load());
+		}
+	}
+
+	MT::Atomic32<int32> isHelperStarted(0);
+
+	// Waits until the helper is about to wait for the counter, so the counter drops to zero while both fibers are waiting
+	struct GatedLeafTask
+	{
+		MT_DECLARE_TASK(GatedLeafTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext&)
+		{
+			int64 timeOut = MT::GetTimeMicroSeconds() + 1000000;
+			while (isHelperStarted.Load() == 0 && MT::GetTimeMicroSeconds() < timeOut)
+			{
+				MT::YieldThread();
+			}
+		}
+	};
+
+	struct HelperWaitTask
+	{
+		MT_DECLARE_TASK(HelperWaitTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		MT::TaskCounter* counter;
+
+		void Do(MT::FiberContext& ctx)
+		{
+			isHelperStarted.Store(1);
+			ctx.WaitCounterAndYield(*counter);
+		}
+	};
+
+	struct CounterOwnerTask
+	{
+		MT_DECLARE_TASK(CounterOwnerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext& ctx)
+		{
+			MT::TaskCounter counter;
+
+			GatedLeafTask leafTasks[2];
+			ctx.RunAsync(MT::TaskGroup::Default(), &leafTasks[0], MT_ARRAY_SIZE(leafTasks), &counter);
+
+			// Helper is not counted, it waits for the same counter
+			HelperWaitTask helperTask;
+			helperTask.counter = &counter;
+			ctx.RunAsync(MT::TaskGroup::Default(), &helperTask, 1);
+
+			ctx.WaitCounterAndYield(counter);
+
+			// Counter is destroyed here, the thread which resumed this fiber can be still registering the helper
+			finishedCount.IncFetch();
+		}
+	};
+
+	// Owner destroys the stack counter right after its wait returns, while other fiber waits for the same counter
+	TEST(WaitCounterOwnerDestroysCounter)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		static const int ROUND_COUNT = 200;
+		for (int round = 0; round < ROUND_COUNT; round++)
+		{
+			finishedCount.Store(0);
+			isHelperStarted.Store(0);
+
+			CounterOwnerTask task;
+			scheduler.RunAsync(MT::TaskGroup::Default(), &task, 1);
+
+			CHECK(scheduler.WaitAll(20000));
+			CHECK_EQUAL(1, finishedCount.Load());
+		}
+	}
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 }
 
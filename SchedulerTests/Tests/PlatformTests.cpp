@@ -263,6 +263,118 @@ SUITE(PlatformTests)
 	}
 
 
+#if MT_PLATFORM_POSIX
+	template<typename EVENT>
+	struct EventPingPong
+	{
+		static const int ITERATIONS_COUNT = 5000;
+
+		EVENT ping;
+		EVENT pong;
+
+		EventPingPong()
+			: ping(MT::EventReset::AUTOMATIC, false)
+			, pong(MT::EventReset::AUTOMATIC, false)
+		{
+		}
+
+		static void PongThreadFunc(void* userData)
+		{
+			EventPingPong* self = (EventPingPong*)userData;
+			for(int i = 0; i < ITERATIONS_COUNT; i++)
+			{
+				CHECK(self->ping.Wait(1000));
+				self->pong.Signal();
+			}
+		}
+
+		static void Run(const char* name)
+		{
+			EventPingPong pingPong;
+
+			// uncontended signal, nobody waits
+			const int uncontendedIterationsCount = 1000000;
+			int64 startTime = MT::GetTimeMicroSeconds();
+			for(int i = 0; i < uncontendedIterationsCount; i++)
+			{
+				pingPong.ping.Signal();
+				CHECK(pingPong.ping.Wait(0));
+			}
+			int64 uncontendedTime = MT::GetTimeMicroSeconds() - startTime;
+
+			// signal/wait round trip between two threads
+			MT::Thread thread;
+			thread.Start(32768, PongThreadFunc, &pingPong);
+
+			startTime = MT::GetTimeMicroSeconds();
+			for(int i = 0; i < ITERATIONS_COUNT; i++)
+			{
+				pingPong.ping.Signal();
+				CHECK(pingPong.pong.Wait(1000));
+			}
+			int64 roundTripTime = MT::GetTimeMicroSeconds() - startTime;
+
+			thread.Join();
+
+			printf("%s: nanoseconds per uncontended signal/wait = %3.2f\n", name, (double)uncontendedTime * 1000.0 / (double)uncontendedIterationsCount);
+			printf("%s: microseconds per signal/wait round trip = %3.2f\n", name, (double)roundTripTime / (double)ITERATIONS_COUNT);
+		}
+	};
+
+	// Compares futex and pthread based events latency
+	TEST(EventLatencyBenchmark)
+	{
+		EventPingPong<MT::EventCondVar>::Run("pthread event");
+#if MT_ENABLE_FUTEX_SYNC
+		EventPingPong<MT::EventFutex>::Run("futex event");
+#endif
+	}
+#endif
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static const int MUTEX_TEST_ITERATIONS_COUNT = 100000;
+
+	MT::Mutex* pTestMutex = nullptr;
+	int32 mutexTestCounter = 0;
+
+	void MutexTestThreadFunc(void*)
+	{
+		for(int i = 0; i < MUTEX_TEST_ITERATIONS_COUNT; i++)
+		{
+			MT::ScopedGuard guard(*pTestMutex);
+
+			// recursive lock
+			MT::ScopedGuard recursiveGuard(*pTestMutex);
+			mutexTestCounter++;
+		}
+	}
+
+	TEST(MutexTest)
+	{
+		MT::Mutex mutex;
+		pTestMutex = &mutex;
+		mutexTestCounter = 0;
+
+		MT::Thread threads[4];
+
+		int64 startTime = MT::GetTimeMicroSeconds();
+		for(uint32 i = 0; i < MT_ARRAY_SIZE(threads); i++)
+		{
+			threads[i].Start(32768, MutexTestThreadFunc, nullptr);
+		}
+
+		for(uint32 i = 0; i < MT_ARRAY_SIZE(threads); i++)
+		{
+			threads[i].Join();
+		}
+		int64 totalTime = MT::GetTimeMicroSeconds() - startTime;
+
+		CHECK_EQUAL(MUTEX_TEST_ITERATIONS_COUNT * (int32)MT_ARRAY_SIZE(threads), mutexTestCounter);
+
+		printf("nanoseconds per lock/unlock = %3.2f\n", (double)totalTime * 1000.0 / (double)(MUTEX_TEST_ITERATIONS_COUNT * MT_ARRAY_SIZE(threads)));
+	}
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 	TEST(SleepTest)
 	{
 
@@ -273,4 +385,41 @@ SUITE(PlatformTests)
 		CHECK( timer.GetPastMilliSeconds() >= 100 );
 	}
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	TEST(CpuTopologyTest)
+	{
+		MT::CpuTopology topology;
+
+		// Unknown processors are remote
+		CHECK_EQUAL(MT::StealDistance::REMOTE, topology.GetDistance(0, 1));
+		CHECK_EQUAL((uint32)MT_NUMA_NODE_ANY, topology.GetNodeId(0));
+
+		if (!topology.Query())
+		{
+			printf("CPU topology is not available\n");
+			return;
+		}
+
+		uint32 cpuCount = topology.GetCpuCount();
+		CHECK(cpuCount > 0);
+		printf("CPU topology: %d logical processors\n", cpuCount);
+
+		for (uint32 a = 0; a < cpuCount; a++)
+		{
+			for (uint32 b = 0; b < cpuCount; b++)
+			{
+				CHECK_EQUAL(topology.GetDistance(a, b), topology.GetDistance(b, a));
+
+				// Processors closer than remote share the node
+				if (topology.GetDistance(a, b) != MT::StealDistance::REMOTE)
+				{
+					CHECK_EQUAL(topology.GetNodeId(a), topology.GetNodeId(b));
+				}
+			}
+		}
+
+		CHECK_EQUAL(MT::StealDistance::REMOTE, topology.GetDistance(0, cpuCount));
+		CHECK_EQUAL((uint32)MT_NUMA_NODE_ANY, topology.GetNodeId(cpuCount));
+	}
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 }
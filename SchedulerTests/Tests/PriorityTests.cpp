@@ -23,6 +23,7 @@
 #include "Tests.h"
 #include <UnitTest++.h>
 #include <MTScheduler.h>
+#include <vector>
 
 /*
 
@@ -59,7 +60,7 @@ SUITE(PriorityTests)
 		}
 	};
 
-	ThreadState workerState[64];
+	std::vector<ThreadState> workerState;
 
 	struct TaskHigh
 	{
@@ -75,7 +76,7 @@ SUITE(PriorityTests)
 		void Do(MT::FiberContext& ctx)
 		{
 			uint32 workerIndex = ctx.GetThreadContext()->workerIndex;
-			MT_ASSERT(workerIndex < MT_ARRAY_SIZE(workerState), "Invalid worker index");
+			MT_ASSERT(workerIndex < workerState.size(), "Invalid worker index");
 			ThreadState& state = workerState[workerIndex];
 
 			CHECK_EQUAL((uint32)0, state.normalProcessed);
@@ -104,7 +105,7 @@ SUITE(PriorityTests)
 		void Do(MT::FiberContext& ctx)
 		{
 			uint32 workerIndex = ctx.GetThreadContext()->workerIndex;
-			MT_ASSERT(workerIndex < MT_ARRAY_SIZE(workerState), "Invalid worker index");
+			MT_ASSERT(workerIndex < workerState.size(), "Invalid worker index");
 			ThreadState& state = workerState[workerIndex];
 
 			CHECK_EQUAL((uint32)0, state.lowProcessed);
@@ -138,7 +139,7 @@ SUITE(PriorityTests)
 		void Do(MT::FiberContext& ctx)
 		{
 			uint32 workerIndex = ctx.GetThreadContext()->workerIndex;
-			MT_ASSERT(workerIndex < MT_ARRAY_SIZE(workerState), "Invalid worker index");
+			MT_ASSERT(workerIndex < workerState.size(), "Invalid worker index");
 			ThreadState& state = workerState[workerIndex];
 
 			state.lowProcessed++;
@@ -196,10 +197,8 @@ SUITE(PriorityTests)
 		switchCountToNormal.Store(0);
 		switchCountToLow.Store(0);
 
-		for(uint32 i = 0; i < MT_ARRAY_SIZE(workerState); i++)
-		{
-			workerState[i].Reset();
-		}
+		workerState.clear();
+		workerState.resize(scheduler.GetWorkersCount());
 
 		scheduler.RunAsync(MT::TaskGroup::Default(), &taskHandles[0], MT_ARRAY_SIZE(taskHandles));
 		CHECK(scheduler.WaitAll(2000));
@@ -24,6 +24,7 @@
 #include <UnitTest++.h>
 #include <MTScheduler.h>
 #include <MTStaticVector.h>
+#include <vector>
 
 SUITE(SimpleTests)
 {
@@ -59,6 +60,25 @@ TEST(RunOneSimpleTask)
 	CHECK(scheduler.WaitAll(1000));
 	CHECK_EQUAL(task.GetSourceData(), task.resultData);
 }
+
+// Checks that single task wakes up one of the parked workers
+TEST(RunOneSimpleTaskOnParkedWorkers)
+{
+	MT::WorkerThreadParams workerParameters[4];
+	MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+	for (int i = 0; i < 100; i++)
+	{
+		// Give workers time to run out of tasks and park
+		MT::Thread::Sleep(1);
+
+		SimpleTask task;
+		scheduler.RunAsync(MT::TaskGroup::Default(), &task, 1);
+
+		CHECK(scheduler.WaitAll(1000));
+		CHECK_EQUAL(task.GetSourceData(), task.resultData);
+	}
+}
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -98,6 +118,452 @@ TEST(ALotOfTasks)
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MT::Atomic32<int32> overflowTestRelease;
+MT::Atomic32<int32> overflowTestCounter;
+
+struct BlockingTask
+{
+	MT_DECLARE_TASK(BlockingTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext&)
+	{
+		while (overflowTestRelease.Load() == 0)
+		{
+			MT::YieldThread();
+		}
+		overflowTestCounter.IncFetch();
+	}
+};
+
+struct OverflowTask
+{
+	MT_DECLARE_TASK(OverflowTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext&)
+	{
+		overflowTestCounter.IncFetch();
+	}
+};
+
+// Checks that submitter is not blocked when worker queue is full
+TEST(QueueOverflow)
+{
+	MT::WorkerThreadParams workerParameters[1];
+	MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+	overflowTestRelease.Store(0);
+	overflowTestCounter.Store(0);
+
+	// Only worker is blocked until all tasks are submitted
+	BlockingTask blockingTask;
+	scheduler.RunAsync(MT::TaskGroup::Default(), &blockingTask, 1);
+
+	static const int TASK_COUNT = 1000;
+	static const int SUBMIT_COUNT = 12;
+	OverflowTask tasks[TASK_COUNT];
+	for (int i = 0; i < SUBMIT_COUNT; i++)
+	{
+		scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+	}
+
+	CHECK(scheduler.GetQueueOverflowCount() > 0);
+
+	overflowTestRelease.Store(1);
+
+	CHECK(scheduler.WaitAll(20000));
+	CHECK_EQUAL(TASK_COUNT * SUBMIT_COUNT + 1, overflowTestCounter.Load());
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace ExternalSubmission
+{
+	static const int TASK_COUNT = 100;
+	static const int SUBMIT_COUNT = 10;
+	static const uint32 PRODUCERS_COUNT = 3;
+
+	MT::Atomic32<int32> counter;
+
+	struct CounterTask
+	{
+		MT_DECLARE_TASK(CounterTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext&)
+		{
+			counter.IncFetch();
+		}
+	};
+
+	void ProducerThreadFunc(void* userData)
+	{
+		MT::TaskScheduler& scheduler = *(MT::TaskScheduler*)userData;
+
+		CounterTask tasks[TASK_COUNT];
+		for (int i = 0; i < SUBMIT_COUNT; i++)
+		{
+			scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+		}
+	}
+
+	// Checks tasks submitted from several external threads at the same time
+	TEST(ExternalThreadsSubmission)
+	{
+		MT::WorkerThreadParams workerParameters[4];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		counter.Store(0);
+
+		MT::Thread producers[PRODUCERS_COUNT];
+		for (uint32 i = 0; i < PRODUCERS_COUNT; i++)
+		{
+			producers[i].Start(65536, ProducerThreadFunc, &scheduler);
+		}
+
+		for (uint32 i = 0; i < PRODUCERS_COUNT; i++)
+		{
+			producers[i].Join();
+		}
+
+		CHECK(scheduler.WaitAll(20000));
+		CHECK_EQUAL(TASK_COUNT * SUBMIT_COUNT * (int)PRODUCERS_COUNT, counter.Load());
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MT::Atomic32<int32> spawnedTasksCounter;
+
+struct SpawnedTask
+{
+	MT_DECLARE_TASK(SpawnedTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext&)
+	{
+		MT::SpinSleepMicroSeconds(50);
+		spawnedTasksCounter.IncFetch();
+	}
+};
+
+struct SpawnerTask
+{
+	MT_DECLARE_TASK(SpawnerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	static const int SUBTASK_COUNT = 64;
+
+	void Do(MT::FiberContext& context)
+	{
+		SpawnedTask tasks[SUBTASK_COUNT];
+		context.RunSubtasksAndYield(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+	}
+};
+
+// Checks tasks added from worker threads and stolen by other workers
+TEST(SpawnAndStealTasks)
+{
+	// Do not pin workers to cores, test must work on any number of cores
+	MT::WorkerThreadParams workerParameters[4];
+	MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+	spawnedTasksCounter.Store(0);
+
+	static const int TASK_COUNT = 32;
+	SpawnerTask tasks[TASK_COUNT];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+	CHECK(scheduler.WaitAll(20000));
+	CHECK_EQUAL(TASK_COUNT * SpawnerTask::SUBTASK_COUNT, spawnedTasksCounter.Load());
+
+	// Subtasks are spawned into the spawner's own queue, other workers can get them only by stealing
+	uint32 histogram[MT::StealDistance::COUNT];
+	scheduler.GetStealDistanceHistogram(histogram);
+
+	uint32 totalStealCount = 0;
+	for (uint32 i = 0; i < MT::StealDistance::COUNT; i++)
+	{
+		totalStealCount += histogram[i];
+	}
+	CHECK(totalStealCount > 0);
+}
+
+// Checks application defined work stealing order
+TEST(SpawnAndStealTasksWithVictimOrder)
+{
+	// Worker 0 steals only from worker 1, worker 1 only from worker 2, etc.
+	static const uint32 victimOrder[4][1] = { {1}, {2}, {3}, {0} };
+
+	MT::WorkerThreadParams workerParameters[4];
+	for (uint32 i = 0; i < MT_ARRAY_SIZE(workerParameters); i++)
+	{
+		workerParameters[i].victimOrder = &victimOrder[i][0];
+		workerParameters[i].victimOrderCount = MT_ARRAY_SIZE(victimOrder[i]);
+	}
+
+	MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+	spawnedTasksCounter.Store(0);
+
+	static const int TASK_COUNT = 32;
+	SpawnerTask tasks[TASK_COUNT];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+	CHECK(scheduler.WaitAll(20000));
+	CHECK_EQUAL(TASK_COUNT * SpawnerTask::SUBTASK_COUNT, spawnedTasksCounter.Load());
+
+	// Workers are not pinned to cores, so all steals are remote
+	uint32 histogram[MT::StealDistance::COUNT];
+	scheduler.GetStealDistanceHistogram(histogram);
+	CHECK_EQUAL((uint32)0, histogram[MT::StealDistance::SMT_SIBLING] + histogram[MT::StealDistance::SHARED_CACHE] + histogram[MT::StealDistance::SAME_NODE]);
+}
+
+// Checks scheduler with small fiber pools and task queues defined at run time
+TEST(RunTasksWithSchedulerConfig)
+{
+	MT::WorkerThreadParams workerParameters[2];
+
+	MT::SchedulerConfig config;
+	config.workerThreadsCount = MT_ARRAY_SIZE(workerParameters);
+	config.workerParameters = workerParameters;
+	config.fiberPools[MT::StackRequirements::STANDARD].maxCount = 16;
+	config.fiberPools[MT::StackRequirements::STANDARD].stackSize = 65536;
+	config.fiberPools[MT::StackRequirements::EXTENDED].maxCount = 2;
+	config.taskQueueCapacity = 128;
+
+	MT::TaskScheduler scheduler(config);
+
+	CHECK_EQUAL((int32)MT_ARRAY_SIZE(workerParameters), scheduler.GetWorkersCount());
+	CHECK_EQUAL((uint32)16, scheduler.GetFibersCount(MT::StackRequirements::STANDARD));
+	CHECK_EQUAL((uint32)2, scheduler.GetFibersCount(MT::StackRequirements::EXTENDED));
+	CHECK_EQUAL((uint32)128, scheduler.GetTaskQueueCapacity());
+
+	spawnedTasksCounter.Store(0);
+
+	// Every spawner holds one fiber until its subtasks are finished
+	static const int TASK_COUNT = 8;
+	static const int SUBMIT_COUNT = 4;
+	for (int i = 0; i < SUBMIT_COUNT; i++)
+	{
+		SpawnerTask tasks[TASK_COUNT];
+		scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+		CHECK(scheduler.WaitAll(20000));
+	}
+
+	CHECK_EQUAL(TASK_COUNT * SUBMIT_COUNT * SpawnerTask::SUBTASK_COUNT, spawnedTasksCounter.Load());
+}
+
+MT::Atomic32<int32> remoteFiberTasksCounter;
+
+struct NodeLocalFiberTask
+{
+	MT_DECLARE_TASK(NodeLocalFiberTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext& context)
+	{
+		// Fiber is taken by the worker which started the task
+		if (context.nodeIndex != context.GetThreadContext()->nodeIndex)
+		{
+			remoteFiberTasksCounter.IncFetch();
+		}
+
+		MT::SpinSleepMicroSeconds(20);
+		spawnedTasksCounter.IncFetch();
+	}
+};
+
+// Checks that workers of different NUMA nodes use fibers of their own nodes
+TEST(RunTasksOnNumaNodes)
+{
+	// Nodes are set explicitly, test must work on a machine with one node too
+	MT::WorkerThreadParams workerParameters[4];
+	for (uint32 i = 0; i < MT_ARRAY_SIZE(workerParameters); i++)
+	{
+		workerParameters[i].numaNode = i % 2;
+	}
+
+	MT::SchedulerConfig config;
+	config.workerThreadsCount = MT_ARRAY_SIZE(workerParameters);
+	config.workerParameters = workerParameters;
+
+	MT::TaskScheduler scheduler(config);
+	CHECK_EQUAL((uint32)2, scheduler.GetNumaNodesCount());
+
+	spawnedTasksCounter.Store(0);
+	remoteFiberTasksCounter.Store(0);
+
+	static const int TASK_COUNT = 256;
+	NodeLocalFiberTask tasks[TASK_COUNT];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+	CHECK(scheduler.WaitAll(20000));
+	CHECK_EQUAL(TASK_COUNT, spawnedTasksCounter.Load());
+	CHECK_EQUAL(0, remoteFiberTasksCounter.Load());
+}
+
+struct IsWorkerThreadTask
+{
+	MT_DECLARE_TASK(IsWorkerThreadTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext& context)
+	{
+		CHECK(context.GetThreadContext()->taskScheduler->IsWorkerThread());
+
+		SpawnedTask subtask;
+		context.RunSubtasksAndYield(MT::TaskGroup::Default(), &subtask, 1);
+	}
+};
+
+// Checks scheduler with more workers than cores (and more than 64 workers)
+TEST(RunTasksOnManyWorkers)
+{
+	static const uint32 WORKERS_COUNT = 256;
+	MT::WorkerThreadParams workerParameters[WORKERS_COUNT];
+
+	MT::SchedulerConfig config;
+	config.workerThreadsCount = WORKERS_COUNT;
+	config.workerParameters = workerParameters;
+	config.schedulerStackSize = 131072;
+	config.taskQueueCapacity = 256;
+
+	MT::TaskScheduler scheduler(config);
+
+	CHECK_EQUAL((int32)WORKERS_COUNT, scheduler.GetWorkersCount());
+	CHECK(scheduler.IsWorkerThread() == false);
+
+	spawnedTasksCounter.Store(0);
+
+	static const int TASK_COUNT = 128;
+	IsWorkerThreadTask tasks[TASK_COUNT];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+	CHECK(scheduler.WaitAll(20000));
+	CHECK_EQUAL(TASK_COUNT, spawnedTasksCounter.Load());
+}
+
+// Reports scheduler construction time and memory with all fibers created up front and with fibers created on demand
+TEST(SchedulerStartupBenchmark)
+{
+	MT::SchedulerConfig eagerConfig;
+	for (uint32 stackClass = 0; stackClass < MT::StackRequirements::COUNT; stackClass++)
+	{
+		eagerConfig.fiberPools[stackClass].initialCount = eagerConfig.fiberPools[stackClass].maxCount;
+	}
+
+	MT::SchedulerConfig lazyConfig;
+
+	const MT::SchedulerConfig* configs[] = { &eagerConfig, &lazyConfig };
+	const char* names[] = { "eager fibers", "lazy fibers" };
+
+	for (uint32 i = 0; i < MT_ARRAY_SIZE(configs); i++)
+	{
+		size_t residentBytesBefore = Tests::GetResidentMemoryBytes();
+		int64 startTime = MT::GetTimeMicroSeconds();
+
+		MT::TaskScheduler scheduler(*configs[i]);
+
+		int64 constructionTime = MT::GetTimeMicroSeconds() - startTime;
+		size_t residentBytesAfter = Tests::GetResidentMemoryBytes();
+
+		uint32 createdFibersCount = 0;
+		for (uint32 stackClass = 0; stackClass < MT::StackRequirements::COUNT; stackClass++)
+		{
+			if (MT::StackRequirements::IsFiberStack((MT::StackRequirements::Type)stackClass))
+			{
+				createdFibersCount += scheduler.GetCreatedFibersCount((MT::StackRequirements::Type)stackClass);
+			}
+		}
+		printf("%s: %d fibers, constructor %d us, resident memory +%d Kb\n", names[i], createdFibersCount, (int)constructionTime, (int)((residentBytesAfter - residentBytesBefore) / 1024));
+	}
+
+	CHECK_EQUAL(MT::MT_INITIAL_STANDART_FIBERS_COUNT, MT::TaskScheduler(lazyConfig).GetCreatedFibersCount(MT::StackRequirements::STANDARD));
+}
+
+// Checks that fibers pool grows on demand up to the maximum count
+TEST(GrowFiberPool)
+{
+	MT::WorkerThreadParams workerParameters[2];
+
+	MT::SchedulerConfig config;
+	config.workerThreadsCount = MT_ARRAY_SIZE(workerParameters);
+	config.workerParameters = workerParameters;
+	config.fiberPools[MT::StackRequirements::STANDARD].maxCount = 128;
+	config.fiberPools[MT::StackRequirements::STANDARD].initialCount = 1;
+	config.fiberPools[MT::StackRequirements::EXTENDED].initialCount = 0;
+
+	MT::TaskScheduler scheduler(config);
+	CHECK_EQUAL((uint32)1, scheduler.GetCreatedFibersCount(MT::StackRequirements::STANDARD));
+	CHECK_EQUAL((uint32)0, scheduler.GetCreatedFibersCount(MT::StackRequirements::EXTENDED));
+
+	spawnedTasksCounter.Store(0);
+
+	// Every spawner holds one fiber until its subtasks are finished
+	static const int TASK_COUNT = 32;
+	SpawnerTask tasks[TASK_COUNT];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+	CHECK(scheduler.WaitAll(20000));
+	CHECK_EQUAL(TASK_COUNT * SpawnerTask::SUBTASK_COUNT, spawnedTasksCounter.Load());
+
+	uint32 createdFibersCount = scheduler.GetCreatedFibersCount(MT::StackRequirements::STANDARD);
+	CHECK(createdFibersCount > 1);
+	CHECK(createdFibersCount <= config.fiberPools[MT::StackRequirements::STANDARD].maxCount);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MT::Atomic32<uint32> reusedFiberTasksCounter;
+uint32 producerFiberIndex = 0;
+
+struct ReusedFiberTask
+{
+	MT_DECLARE_TASK(ReusedFiberTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext& context)
+	{
+		if (context.fiberIndex == producerFiberIndex)
+		{
+			reusedFiberTasksCounter.IncFetch();
+		}
+	}
+};
+
+struct ProducerTask
+{
+	MT_DECLARE_TASK(ProducerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	static const int TASK_COUNT = 256;
+	ReusedFiberTask tasks[TASK_COUNT];
+
+	void Do(MT::FiberContext& context)
+	{
+		producerFiberIndex = context.fiberIndex;
+		context.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+	}
+};
+
+// Checks that finished fiber runs the next queued tasks itself
+TEST(ReuseFiberForQueuedTasks)
+{
+	MT::WorkerThreadParams workerParameters[1];
+
+	MT::SchedulerConfig config;
+	config.workerThreadsCount = MT_ARRAY_SIZE(workerParameters);
+	config.workerParameters = workerParameters;
+	config.stealMode = MT::TaskStealingMode::DISABLED;
+
+	MT::TaskScheduler scheduler(config);
+
+	reusedFiberTasksCounter.Store(0);
+
+	ProducerTask task;
+	scheduler.RunAsync(MT::TaskGroup::Default(), &task, 1);
+
+	CHECK(scheduler.WaitAll(1000));
+
+	// Fiber runs a limited number of tasks in a row, then it goes back to the pool and can be given to the next task
+	CHECK(reusedFiberTasksCounter.Load() >= (uint32)MT_FIBER_REUSE_MAX_COUNT);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -119,7 +585,7 @@ struct WorkerThreadState
 };
 
 
-WorkerThreadState workerStates[64];
+std::vector<WorkerThreadState> workerStates;
 
 uint32 TASK_COUNT_PER_WORKER = 0;
 
@@ -139,7 +605,7 @@ struct YieldTask
 
 	 volatile WorkerThreadState* GetWorkerState( volatile uint32 workerIndex) volatile
 	{
-		MT_ASSERT(workerIndex < MT_ARRAY_SIZE(workerStates), "Invalid worker index");
+		MT_ASSERT(workerIndex < workerStates.size(), "Invalid worker index");
 		volatile WorkerThreadState& state = workerStates[workerIndex];
 		return &state;
 	}
@@ -191,11 +657,8 @@ TEST(YieldTasks)
 		tasks.PushBack(YieldTask());
 	}
 
-	for(int32 i = 0; i < workersCount; i++)
-	{
-		WorkerThreadState& state = workerStates[i];
-		state.Reset();
-	}
+	workerStates.clear();
+	workerStates.resize(workersCount);
 
 
 	scheduler.RunAsync(MT::TaskGroup::Default(), tasks.Begin(), (uint32)tasks.Size());
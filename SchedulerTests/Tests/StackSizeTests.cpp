@@ -61,6 +61,36 @@ struct ExtendedStackSizeTask
 };
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct SmallStackSizeTask
+{
+	MT_DECLARE_TASK(SmallStackSizeTask, MT::StackRequirements::SMALL, MT::TaskPriority::NORMAL, MT::Color::Green);
+
+	void Do(MT::FiberContext&)
+	{
+		byte stackData[4096];
+		for (uint32 i = 0; i < MT_ARRAY_SIZE(stackData); i++)
+		{
+			stackData[i] = 0x0D;
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct LargeStackSizeTask
+{
+	MT_DECLARE_TASK(LargeStackSizeTask, MT::StackRequirements::LARGE, MT::TaskPriority::NORMAL, MT::Color::Yellow);
+
+	void Do(MT::FiberContext&)
+	{
+		byte stackData[65536];
+		for (uint32 i = 0; i < MT_ARRAY_SIZE(stackData); i++)
+		{
+			stackData[i] = 0x0D;
+		}
+	}
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST(RunStandartTasks)
 {
@@ -108,6 +138,378 @@ TEST(RunMixedTasks)
 	CHECK(scheduler.WaitAll(1000));
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Checks that every stack class uses its own fibers pool
+TEST(RunAllStackClasses)
+{
+	MT::TaskScheduler scheduler;
+
+	MT::TaskPool<SmallStackSizeTask, 64> smallTaskPool;
+	MT::TaskPool<StandartStackSizeTask, 64> standardTaskPool;
+	MT::TaskPool<LargeStackSizeTask, 64> largeTaskPool;
+	MT::TaskPool<ExtendedStackSizeTask, 64> extendedTaskPool;
+
+	MT::TaskHandle taskHandles[100];
+	for (size_t i = 0; i < MT_ARRAY_SIZE(taskHandles); ++i)
+	{
+		switch(i % 4)
+		{
+		case 0:
+			taskHandles[i] = smallTaskPool.Alloc(SmallStackSizeTask());
+			break;
+		case 1:
+			taskHandles[i] = standardTaskPool.Alloc(StandartStackSizeTask());
+			break;
+		case 2:
+			taskHandles[i] = largeTaskPool.Alloc(LargeStackSizeTask());
+			break;
+		default:
+			taskHandles[i] = extendedTaskPool.Alloc(ExtendedStackSizeTask());
+			break;
+		}
+	}
+
+	scheduler.RunAsync(MT::TaskGroup::Default(), &taskHandles[0], MT_ARRAY_SIZE(taskHandles));
+	CHECK(scheduler.WaitAll(1000));
+
+	CHECK(scheduler.GetPeakFibersInUseCount(MT::StackRequirements::SMALL) > 0);
+	CHECK(scheduler.GetPeakFibersInUseCount(MT::StackRequirements::STANDARD) > 0);
+	CHECK(scheduler.GetPeakFibersInUseCount(MT::StackRequirements::LARGE) > 0);
+	CHECK(scheduler.GetPeakFibersInUseCount(MT::StackRequirements::EXTENDED) > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Touches one cache line per stack page and lets other tasks run in between, so stacks of many fibers are in use
+struct StackWalkTask
+{
+	MT_DECLARE_TASK(StackWalkTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext& context)
+	{
+		volatile byte stackData[16384];
+		for (uint32 pass = 0; pass < 8; pass++)
+		{
+			for (uint32 i = 0; i < MT_ARRAY_SIZE(stackData); i += 4096)
+			{
+				stackData[i] = (byte)pass;
+			}
+			context.Yield();
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Compares regular and huge pages for fiber stacks and task queues
+TEST(HugePagesBenchmark)
+{
+	static const uint32 ROUNDS_COUNT = 50;
+
+	const char* names[] = { "regular pages", "huge pages" };
+	for (uint32 mode = 0; mode < MT_ARRAY_SIZE(names); mode++)
+	{
+		// Worker threads are created after the counter, their misses are added when they exit
+		Tests::TlbMissCounter tlbMissCounter;
+		int64 elapsedTime = 0;
+		{
+			MT::SchedulerConfig config;
+			config.useHugePages = (mode != 0);
+			MT::TaskScheduler scheduler(config);
+
+			// The first round creates fibers and commits stack pages, it is not measured
+			StackWalkTask tasks[200];
+			scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+			CHECK(scheduler.WaitAll(2000));
+
+			int64 startTime = MT::GetTimeMicroSeconds();
+			for (uint32 round = 0; round < ROUNDS_COUNT; round++)
+			{
+				scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+				CHECK(scheduler.WaitAll(2000));
+			}
+			elapsedTime = MT::GetTimeMicroSeconds() - startTime;
+		}
+
+		if (tlbMissCounter.IsAvailable())
+		{
+			printf("%s: %d us, %llu dTLB misses\n", names[mode], (int)elapsedTime, tlbMissCounter.GetCount());
+		} else
+		{
+			printf("%s: %d us, dTLB misses counter is not available\n", names[mode], (int)elapsedTime);
+		}
+	}
+}
+
+#if !MT_ENABLE_STACK_USAGE_TRACKING
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Touches a lot of stack and keeps the fiber busy until the nested subtasks are finished
+struct DeepChainTask
+{
+	MT_DECLARE_TASK(DeepChainTask, MT::StackRequirements::LARGE, MT::TaskPriority::NORMAL, MT::Color::Yellow);
+
+	uint32 depth;
+
+	DeepChainTask(uint32 _depth)
+		: depth(_depth)
+	{
+	}
+
+	void Do(MT::FiberContext& context)
+	{
+		volatile byte stackData[98304];
+		for (uint32 i = 0; i < MT_ARRAY_SIZE(stackData); i++)
+		{
+			stackData[i] = 0x0D;
+		}
+
+		if (depth > 0)
+		{
+			DeepChainTask subtask(depth - 1);
+			context.RunSubtasksAndYield(MT::TaskGroup::Default(), &subtask, 1);
+		}
+	}
+};
+
+static size_t RunDeepChainTask(MT::TaskScheduler& scheduler)
+{
+	DeepChainTask task(32);
+	scheduler.RunAsync(MT::TaskGroup::Default(), &task, 1);
+	CHECK(scheduler.WaitAll(2000));
+	return Tests::GetResidentMemoryBytes();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Checks that idle fibers return touched stack pages to the OS
+TEST(ReleaseIdleFiberStacks)
+{
+	static const size_t MIN_RELEASED_BYTES = 1024 * 1024;
+
+	// Explicit release
+	{
+		MT::TaskScheduler scheduler;
+
+		size_t residentBytesBurst = RunDeepChainTask(scheduler);
+		CHECK(scheduler.GetPeakFibersInUseCount(MT::StackRequirements::LARGE) > 16);
+
+		scheduler.ReleaseIdleFiberStacks();
+		size_t residentBytesReleased = Tests::GetResidentMemoryBytes();
+
+		CHECK(residentBytesReleased + MIN_RELEASED_BYTES < residentBytesBurst);
+		printf("explicit release: resident memory after burst %d Kb, after release %d Kb\n", (int)(residentBytesBurst / 1024), (int)(residentBytesReleased / 1024));
+	}
+
+	// Idle workers release stacks
+	{
+		MT::SchedulerConfig config;
+		config.fiberStackReleaseDelay = 10;
+		MT::TaskScheduler scheduler(config);
+
+		size_t residentBytesBurst = RunDeepChainTask(scheduler);
 
+		// Wake up workers after the delay, idle pass runs before worker parks again
+		MT::Thread::Sleep(20);
+		StandartStackSizeTask wakeUpTask;
+		scheduler.RunAsync(MT::TaskGroup::Default(), &wakeUpTask, 1);
+		CHECK(scheduler.WaitAll(1000));
+
+		size_t residentBytesReleased = residentBytesBurst;
+		for (int i = 0; i < 100 && residentBytesReleased + MIN_RELEASED_BYTES >= residentBytesBurst; i++)
+		{
+			MT::Thread::Sleep(10);
+			residentBytesReleased = Tests::GetResidentMemoryBytes();
+		}
+
+		CHECK(residentBytesReleased + MIN_RELEASED_BYTES < residentBytesBurst);
+		printf("release after delay: resident memory after burst %d Kb, after release %d Kb\n", (int)(residentBytesBurst / 1024), (int)(residentBytesReleased / 1024));
+	}
+}
+
+#endif
+
+#if MT_ENABLE_STACK_USAGE_TRACKING
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct DeepStackTask
+{
+	MT_DECLARE_TASK(DeepStackTask, MT::StackRequirements::LARGE, MT::TaskPriority::NORMAL, MT::Color::Yellow);
+
+	void Do(MT::FiberContext&)
+	{
+		volatile byte stackData[65536];
+		for (uint32 i = 0; i < MT_ARRAY_SIZE(stackData); i++)
+		{
+			stackData[i] = 0x0D;
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Checks that peak stack depth is reported per task type and per stack class
+TEST(StackUsageReport)
+{
+	MT::TaskScheduler scheduler;
+
+	DeepStackTask deepTasks[16];
+	SmallStackSizeTask smallTasks[16];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &deepTasks[0], MT_ARRAY_SIZE(deepTasks));
+	scheduler.RunAsync(MT::TaskGroup::Default(), &smallTasks[0], MT_ARRAY_SIZE(smallTasks));
+	CHECK(scheduler.WaitAll(1000));
+
+	CHECK(scheduler.GetPeakStackUsage(MT::StackRequirements::LARGE) >= 65536);
+	CHECK(scheduler.GetPeakStackUsage(MT::StackRequirements::LARGE) < MT::MT_LARGE_FIBER_STACK_SIZE);
+
+	static const char* stackClassNames[MT::StackRequirements::COUNT] = { "invalid", "small", "standard", "large", "extended", "stackless" };
+	for (int32 i = MT::StackRequirements::SMALL; i < MT::StackRequirements::STACKLESS; i++)
+	{
+		printf("%s stack: peak %u bytes\n", stackClassNames[i], scheduler.GetPeakStackUsage((MT::StackRequirements::Type)i));
+	}
+
+	MT::TaskStackUsage items[MT_STACK_USAGE_MAX_TASK_TYPES];
+	uint32 count = scheduler.GetTaskStackUsage(&items[0], MT_ARRAY_SIZE(items));
+
+	bool isDeepTaskFound = false;
+	for (uint32 i = 0; i < count; i++)
+	{
+		const MT::TaskStackUsage& item = items[i];
+		printf("task %p (%s stack): peak %u bytes\n", (void*)item.taskFunc, stackClassNames[item.stackRequirements], item.peakBytes);
+
+		if (item.taskFunc == DeepStackTask::TaskEntryPoint)
+		{
+			isDeepTaskFound = true;
+			CHECK(item.stackRequirements == MT::StackRequirements::LARGE);
+			CHECK(item.peakBytes >= 65536);
+		}
+	}
+	CHECK(isDeepTaskFound);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MT::Atomic32<uint32> finishedYieldingTasksCount;
+
+struct YieldingExtendedTask
+{
+	MT_DECLARE_TASK(YieldingExtendedTask, MT::StackRequirements::EXTENDED, MT::TaskPriority::NORMAL, MT::Color::Red);
+
+	void Do(MT::FiberContext& context)
+	{
+		// Yielded task keeps its fiber, so the next tasks can't get one
+		for (uint32 i = 0; i < 4; i++)
+		{
+			context.Yield();
+		}
+
+		finishedYieldingTasksCount.IncFetch();
+	}
+};
+
+// Checks that tasks are deferred until fiber is free instead of failing when all fibers are in use
+TEST(DeferTasksWhenFibersExhausted)
+{
+	MT::WorkerThreadParams workerParameters[2];
+
+	MT::SchedulerConfig config;
+	config.workerThreadsCount = MT_ARRAY_SIZE(workerParameters);
+	config.workerParameters = workerParameters;
+	config.fiberPools[MT::StackRequirements::EXTENDED].maxCount = 2;
+	config.fiberPools[MT::StackRequirements::EXTENDED].initialCount = 2;
+
+	MT::TaskScheduler scheduler(config);
+
+	finishedYieldingTasksCount.Store(0);
+
+	YieldingExtendedTask tasks[64];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+
+	ExtendedStackSizeTask extendedTasks[16];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &extendedTasks[0], MT_ARRAY_SIZE(extendedTasks));
+
+	CHECK(scheduler.WaitAll(10000));
+	CHECK_EQUAL((uint32)MT_ARRAY_SIZE(tasks), finishedYieldingTasksCount.Load());
+
+	CHECK(scheduler.GetDeferredTasksCount() > 0);
+	CHECK_EQUAL(config.fiberPools[MT::StackRequirements::EXTENDED].maxCount, scheduler.GetPeakFibersInUseCount(MT::StackRequirements::EXTENDED));
+
+	printf("%d tasks deferred, peak fibers in use %d\n", scheduler.GetDeferredTasksCount(), scheduler.GetPeakFibersInUseCount(MT::StackRequirements::EXTENDED));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MT::Atomic32<uint32> finishedLeafTasksCount;
+
+template<MT::StackRequirements::Type STACK_REQUIREMENTS>
+struct LeafTask
+{
+	MT_DECLARE_TASK(LeafTask, STACK_REQUIREMENTS, MT::TaskPriority::NORMAL, MT::Color::Green);
+
+	void Do(MT::FiberContext&)
+	{
+		finishedLeafTasksCount.IncFetch();
+	}
+};
+
+typedef LeafTask<MT::StackRequirements::STACKLESS> StacklessLeafTask;
+
+struct StacklessParentTask
+{
+	MT_DECLARE_TASK(StacklessParentTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+	void Do(MT::FiberContext& context)
+	{
+		// Parent fiber is resumed by the last stackless subtask
+		StacklessLeafTask subtasks[8];
+		context.RunSubtasksAndYield(MT::TaskGroup::Default(), &subtasks[0], MT_ARRAY_SIZE(subtasks));
+		CHECK(finishedLeafTasksCount.Load() >= MT_ARRAY_SIZE(subtasks));
+	}
+};
+
+// Checks that stackless tasks don't use fibers
+TEST(RunStacklessTasks)
+{
+	MT::SchedulerConfig config;
+	config.fiberPools[MT::StackRequirements::STANDARD].initialCount = 1;
+
+	MT::TaskScheduler scheduler(config);
+
+	finishedLeafTasksCount.Store(0);
+
+	StacklessLeafTask tasks[1000];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+	CHECK(scheduler.WaitAll(1000));
+	CHECK_EQUAL((uint32)MT_ARRAY_SIZE(tasks), finishedLeafTasksCount.Load());
+	CHECK_EQUAL((uint32)0, scheduler.GetPeakFibersInUseCount(MT::StackRequirements::STANDARD));
+
+	StacklessParentTask parentTasks[16];
+	scheduler.RunAsync(MT::TaskGroup::Default(), &parentTasks[0], MT_ARRAY_SIZE(parentTasks));
+	CHECK(scheduler.WaitAll(1000));
+	CHECK_EQUAL((uint32)(MT_ARRAY_SIZE(tasks) + MT_ARRAY_SIZE(parentTasks) * 8), finishedLeafTasksCount.Load());
+}
+
+template<typename TTask>
+static uint64 RunLeafTasks(MT::TaskScheduler& scheduler, uint32 passCount)
+{
+	static TTask tasks[1024];
+
+	int64 startTime = MT::GetTimeMicroSeconds();
+	for (uint32 pass = 0; pass < passCount; pass++)
+	{
+		scheduler.RunAsync(MT::TaskGroup::Default(), &tasks[0], MT_ARRAY_SIZE(tasks));
+		CHECK(scheduler.WaitAll(10000));
+	}
+	return (uint64)(MT::GetTimeMicroSeconds() - startTime);
+}
+
+// Compares tiny task throughput with and without fibers
+TEST(StacklessTasksBenchmark)
+{
+	MT::TaskScheduler scheduler;
+
+	static const uint32 PASS_COUNT = 100;
+	uint64 fiberTime = RunLeafTasks< LeafTask<MT::StackRequirements::STANDARD> >(scheduler, PASS_COUNT);
+	uint64 stacklessTime = RunLeafTasks<StacklessLeafTask>(scheduler, PASS_COUNT);
+
+	double tasksCount = (double)(PASS_COUNT * 1024);
+	printf("Leaf task: fiber %3.1f ns, stackless %3.1f ns\n", (double)fiberTime * 1000.0 / tasksCount, (double)stacklessTime * 1000.0 / tasksCount);
+}
 
 }
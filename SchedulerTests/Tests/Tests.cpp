@@ -22,6 +22,19 @@
 
 #include "Tests.h"
 #include <UnitTest++.h>
+#include <MTConfig.h>
+
+#if MT_PLATFORM_POSIX
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+#if MT_PLATFORM_POSIX && defined(__linux__)
+#include <string.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define MT_TESTS_PERF_EVENTS_SUPPORTED (1)
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -29,3 +42,71 @@ int Tests::RunAll()
 {
 	return UnitTest::RunAllTests();
 }
+
+size_t Tests::GetResidentMemoryBytes()
+{
+#if MT_PLATFORM_POSIX
+	// Second value is the number of resident pages
+	FILE* file = fopen("/proc/self/statm", "r");
+	if (file == nullptr)
+	{
+		return 0;
+	}
+
+	unsigned long totalPages = 0;
+	unsigned long residentPages = 0;
+	int res = fscanf(file, "%lu %lu", &totalPages, &residentPages);
+	fclose(file);
+
+	if (res != 2)
+	{
+		return 0;
+	}
+	return (size_t)residentPages * (size_t)sysconf(_SC_PAGE_SIZE);
+#else
+	return 0;
+#endif
+}
+
+Tests::TlbMissCounter::TlbMissCounter()
+	: fd(-1)
+{
+#ifdef MT_TESTS_PERF_EVENTS_SUPPORTED
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+Tests::TlbMissCounter::~TlbMissCounter()
+{
+#ifdef MT_TESTS_PERF_EVENTS_SUPPORTED
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+#endif
+}
+
+bool Tests::TlbMissCounter::IsAvailable() const
+{
+	return fd >= 0;
+}
+
+unsigned long long Tests::TlbMissCounter::GetCount() const
+{
+	unsigned long long count = 0;
+#ifdef MT_TESTS_PERF_EVENTS_SUPPORTED
+	if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count))
+	{
+		return 0;
+	}
+#endif
+	return count;
+}
@@ -22,7 +22,27 @@
 
 #pragma once
 
+#include <stddef.h>
+
 namespace Tests
 {
 	int RunAll();
+
+	// Resident set size of the test process in bytes, 0 if not available on this platform
+	size_t GetResidentMemoryBytes();
+
+	// Data TLB misses of the calling thread and threads created after the counter (counted when they exit).
+	// Not available on all platforms, kernels and virtual machines.
+	class TlbMissCounter
+	{
+		int fd;
+
+	public:
+
+		TlbMissCounter();
+		~TlbMissCounter();
+
+		bool IsAvailable() const;
+		unsigned long long GetCount() const;
+	};
 }
\ No newline at end of file
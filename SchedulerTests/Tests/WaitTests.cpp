@@ -129,6 +129,65 @@ namespace SimpleWaitFromSubtask
 		printf("WaitGroup(33) = %3.2f ms\n", waitTime / 1000.0f);
 	}
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	MT::Atomic32<int32> isLatencyTaskStarted;
+	int64 latencyTaskFinishTime = 0;
+
+	struct LatencyTask
+	{
+		MT_DECLARE_TASK(LatencyTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		void Do(MT::FiberContext&)
+		{
+			isLatencyTaskStarted.Store(1);
+			MT::SpinSleepMilliSeconds(20);
+			latencyTaskFinishTime = MT::GetTimeMicroSeconds();
+		}
+	};
+
+	// Time between the end of the last task and the return from WaitGroup. Task is long enough for the waiter to stop spinning
+	// and fall asleep, so the latency is the cost of the wake up, not the polling interval.
+	TEST(WaitGroupLatencyTest)
+	{
+		MT::TaskScheduler scheduler;
+
+		MT::TaskGroup myGroup = scheduler.CreateGroup();
+
+		static const int ITERATIONS_COUNT = 25;
+
+		int64 totalLatency = 0;
+		int64 maxLatency = 0;
+		for (int i = 0; i < ITERATIONS_COUNT; i++)
+		{
+			isLatencyTaskStarted.Store(0);
+
+			LatencyTask task;
+			scheduler.RunAsync(myGroup, &task, 1);
+
+			// Task must be taken by worker, not by the waiting thread
+			while (isLatencyTaskStarted.Load() == 0)
+			{
+				MT::YieldThread();
+			}
+
+			CHECK(scheduler.WaitGroup(myGroup, 2000));
+
+			int64 latency = MT::GetTimeMicroSeconds() - latencyTaskFinishTime;
+			totalLatency += latency;
+			maxLatency = MT::Max(maxLatency, latency);
+		}
+
+		int64 averageLatency = totalLatency / ITERATIONS_COUNT;
+		printf("WaitGroup wake up latency: average %d us, max %d us\n", (int32)averageLatency, (int32)maxLatency);
+
+		// Waiter used to poll the group every 10 ms
+		CHECK(averageLatency < 1000);
+		CHECK(maxLatency < 10000);
+
+		scheduler.ReleaseGroup(myGroup);
+	}
+
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -186,6 +245,97 @@ namespace SimpleWaitFromSubtask
 	}
 
 
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+namespace ManyExternalWaiters
+{
+	static const uint32 WAITERS_COUNT = 12;
+	static const int TASK_COUNT = 64;
+	static const int ROUND_COUNT = 10;
+
+	MT::Atomic32<int32> finishedCount;
+	MT::Atomic32<int32> errorsCount;
+
+	struct CheckWorkerTask
+	{
+		MT_DECLARE_TASK(CheckWorkerTask, MT::StackRequirements::STANDARD, MT::TaskPriority::NORMAL, MT::Color::Blue);
+
+		MT::TaskScheduler* scheduler;
+
+		CheckWorkerTask()
+			: scheduler(nullptr)
+		{
+		}
+
+		void Do(MT::FiberContext&)
+		{
+			MT::SpinSleepMicroSeconds(50);
+
+			// Worker or waiting external thread
+			if (scheduler->IsWorkerThread() == false)
+			{
+				errorsCount.IncFetch();
+			}
+
+			finishedCount.IncFetch();
+		}
+	};
+
+	void WaiterThreadFunc(void* userData)
+	{
+		MT::TaskScheduler& scheduler = *(MT::TaskScheduler*)userData;
+
+		MT::TaskGroup group = scheduler.CreateGroup();
+
+		CheckWorkerTask tasks[TASK_COUNT];
+		for (int i = 0; i < TASK_COUNT; i++)
+		{
+			tasks[i].scheduler = &scheduler;
+		}
+
+		for (int round = 0; round < ROUND_COUNT; round++)
+		{
+			scheduler.RunAsync(group, &tasks[0], MT_ARRAY_SIZE(tasks));
+
+			if (scheduler.WaitGroup(group, 20000) == false)
+			{
+				errorsCount.IncFetch();
+			}
+
+			// Thread is not a worker anymore
+			if (scheduler.IsWorkerThread())
+			{
+				errorsCount.IncFetch();
+			}
+		}
+
+		scheduler.ReleaseGroup(group);
+	}
+
+	// More external threads are waiting at the same time than there are workers
+	TEST(ManyConcurrentExternalWaiters)
+	{
+		MT::WorkerThreadParams workerParameters[2];
+		MT::TaskScheduler scheduler(MT_ARRAY_SIZE(workerParameters), workerParameters);
+
+		finishedCount.Store(0);
+		errorsCount.Store(0);
+
+		MT::Thread waiters[WAITERS_COUNT];
+		for (uint32 i = 0; i < WAITERS_COUNT; i++)
+		{
+			waiters[i].Start(65536, WaiterThreadFunc, &scheduler);
+		}
+
+		for (uint32 i = 0; i < WAITERS_COUNT; i++)
+		{
+			waiters[i].Join();
+		}
+
+		CHECK_EQUAL(0, errorsCount.Load());
+		CHECK_EQUAL(TASK_COUNT * ROUND_COUNT * (int32)WAITERS_COUNT, finishedCount.Load());
+		CHECK_EQUAL(false, scheduler.IsWorkerThread());
+	}
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 }